@@ -20,8 +20,15 @@
 #include <windows.h>
 #endif
 
-#if HAVE_STAT_INO
+#if HAVE_STAT
 #include <sys/stat.h>
+#endif
+
+#define	GZINPUT		(HAVE_ZLIB && HAVE_STAT)
+#if GZINPUT
+#include <zlib.h>
+#endif
+#if HAVE_STAT_INO
 extern dev_t curr_dev;
 extern ino_t curr_ino;
 #endif
@@ -29,6 +36,10 @@ extern ino_t curr_ino;
 typedef POSITION BLOCKNUM;
 
 public int ignore_eoi;
+public long stat_ch_miss;	/* Number of blocks not found in a buffer */
+public long stat_ch_reads;	/* Number of reads from input files */
+public POSITION stat_ch_bytes;	/* Number of bytes read from input files */
+public double stat_ch_time;	/* Time spent reading input files */
 
 /*
  * Pool of buffers holding the most recently used blocks of the input file.
@@ -65,6 +76,9 @@ struct filestate {
 	BLOCKNUM block;
 	unsigned int offset;
 	POSITION fsize;
+	time_type mtime;	/* Modification time when buffers were emptied */
+	FILE *spool;		/* Copy of data read from a pipe (CH_SPOOL) */
+	void *zfile;		/* Decompressor, if the file is compressed */
 };
 
 #define	ch_bufhead	thisfile->buflist.next
@@ -76,6 +90,8 @@ struct filestate {
 #define	ch_fsize	thisfile->fsize
 #define	ch_flags	thisfile->flags
 #define	ch_file		thisfile->file
+#define	ch_spool	thisfile->spool
+#define	ch_zfile	((struct zfile *) thisfile->zfile)
 
 #define	END_OF_CHAIN	(&thisfile->buflist)
 #define	END_OF_HCHAIN(h) (&thisfile->hashtbl[h])
@@ -129,6 +145,9 @@ extern int sigs;
 extern int secure;
 extern int screen_trashed;
 extern int follow_mode;
+extern int decompress;
+extern int decompress_span;
+extern char *statsfile;
 extern constant char helpdata[];
 extern constant int size_helpdata;
 extern IFILE curr_ifile;
@@ -139,6 +158,470 @@ extern char *namelogfile;
 
 static int ch_addbuf();
 
+#if GZINPUT
+/*
+ * Reading gzip-compressed files.
+ * The data is decompressed as it is read, and every "span" bytes
+ * (of uncompressed data) the state of the decompressor is saved
+ * in a checkpoint.  To get to any position in the file, we need only
+ * start again from the last checkpoint before it.
+ * The most recent span of uncompressed data is kept in a circular
+ * history buffer, so reading backwards doesn't restart too often.
+ */
+#define	ZWINSIZE	32768	/* Size of the deflate dictionary */
+#define	ZINSIZE		65536	/* Size of the compressed input buffer */
+
+struct zpoint {
+	POSITION out;		/* Position in uncompressed data */
+	POSITION in;		/* Position in compressed file */
+	int bits;		/* Bits of the byte before "in" still to use */
+	unsigned char *window;	/* Compressed copy of the dictionary */
+	unsigned long wsize;	/* Size of window */
+	unsigned long wlen;	/* Size of the dictionary */
+};
+
+struct zfile {
+	z_stream strm;
+	int active;		/* Is strm initialized? */
+	int raw;		/* Restarted in the middle of a gzip member? */
+	int newmember;		/* At the start of a gzip member? */
+	int skip;		/* Bytes of gzip trailer to skip (raw mode) */
+	POSITION in;		/* Position in compressed file of next read */
+	POSITION out;		/* Position in uncompressed data of next byte */
+	POSITION low;		/* Lowest position in the history buffer */
+	POSITION size;		/* Size of uncompressed data, if known */
+	POSITION rawsize;	/* Size of compressed file */
+	time_type mtime;	/* Modification time of compressed file */
+	long span;		/* Distance between checkpoints */
+	unsigned char *hist;	/* History buffer (span bytes) */
+	struct zpoint *points;	/* Checkpoints, in order of position */
+	int npoints;
+	int maxpoints;
+	unsigned char inbuf[ZINSIZE];
+};
+
+static unsigned char zdict[ZWINSIZE];
+
+/*
+ * Does a file appear to be unchanged since zf_open?
+ */
+	static int
+zf_changed(zf, f)
+	struct zfile *zf;
+	int f;
+{
+	struct stat statbuf;
+
+	if (fstat(f, &statbuf) < 0)
+		return (TRUE);
+	return ((POSITION) statbuf.st_size != zf->rawsize ||
+		statbuf.st_mtime != zf->mtime);
+}
+
+/*
+ * Set up to read a file, if it is compressed by gzip.
+ * Return NULL if it isn't.
+ */
+	static struct zfile *
+zf_open(f)
+	int f;
+{
+	struct zfile *zf;
+	struct stat statbuf;
+	unsigned char magic[2];
+
+	if (lseek(f, (off_t)0, SEEK_SET) == BAD_LSEEK ||
+	    read(f, magic, 2) != 2 || magic[0] != 0x1f || magic[1] != 0x8b ||
+	    fstat(f, &statbuf) < 0)
+		return (NULL);
+	zf = (struct zfile *) ecalloc(1, sizeof(struct zfile));
+	zf->span = (long) decompress_span * 1024;
+	if (zf->span < 2 * ZWINSIZE)
+		zf->span = 2 * ZWINSIZE;
+	zf->hist = (unsigned char *) malloc(zf->span);
+	if (zf->hist == NULL)
+	{
+		free(zf);
+		return (NULL);
+	}
+	zf->size = NULL_POSITION;
+	zf->rawsize = (POSITION) statbuf.st_size;
+	zf->mtime = statbuf.st_mtime;
+	return (zf);
+}
+
+/*
+ * Free everything belonging to a zfile.
+ */
+	static void
+zf_close(zf)
+	struct zfile *zf;
+{
+	int i;
+
+	if (zf->active)
+		inflateEnd(&zf->strm);
+	for (i = 0;  i < zf->npoints;  i++)
+		free(zf->points[i].window);
+	if (zf->points != NULL)
+		free(zf->points);
+	free(zf->hist);
+	free(zf);
+}
+
+/*
+ * Return the amount of memory used by a zfile.
+ */
+	static long
+zf_space(zf)
+	struct zfile *zf;
+{
+	long space;
+	int i;
+
+	space = sizeof(struct zfile) + zf->span + 
+		zf->maxpoints * sizeof(struct zpoint);
+	for (i = 0;  i < zf->npoints;  i++)
+		space += zf->points[i].wsize;
+	return (space);
+}
+
+/*
+ * Copy the last n bytes of uncompressed data 
+ * from the circular history buffer to buf.
+ */
+	static void
+zf_gethist(zf, buf, n)
+	struct zfile *zf;
+	unsigned char *buf;
+	long n;
+{
+	long off = (long) ((zf->out - n) % zf->span);
+	long len = zf->span - off;
+
+	if (len > n)
+		len = n;
+	memcpy(buf, zf->hist + off, len);
+	memcpy(buf + len, zf->hist, n - len);
+}
+
+/*
+ * Save a checkpoint at the current position.
+ * We must be at the end of a deflate block.
+ */
+	static void
+zf_addpoint(zf)
+	struct zfile *zf;
+{
+	struct zpoint *p;
+	unsigned long wlen;
+	unsigned long wsize;
+	unsigned char *window;
+
+	if (zf->npoints >= zf->maxpoints)
+	{
+		int n = (zf->maxpoints > 0) ? 2 * zf->maxpoints : 64;
+		p = (struct zpoint *) calloc(n, sizeof(struct zpoint));
+		if (p == NULL)
+			return;
+		if (zf->points != NULL)
+		{
+			memcpy(p, zf->points, zf->npoints * sizeof(struct zpoint));
+			free(zf->points);
+		}
+		zf->points = p;
+		zf->maxpoints = n;
+	}
+	wlen = (zf->out - zf->low < ZWINSIZE) ? 
+		(unsigned long) (zf->out - zf->low) : ZWINSIZE;
+	zf_gethist(zf, zdict, (long) wlen);
+	wsize = compressBound(wlen);
+	window = (unsigned char *) malloc(wsize);
+	if (window == NULL)
+		return;
+	if (compress2(window, &wsize, zdict, wlen, Z_BEST_SPEED) != Z_OK)
+	{
+		free(window);
+		return;
+	}
+	p = &zf->points[zf->npoints++];
+	p->out = zf->out;
+	p->in = zf->in - zf->strm.avail_in;
+	p->bits = zf->strm.data_type & 7;
+	p->window = window;
+	p->wsize = wsize;
+	p->wlen = wlen;
+}
+
+/*
+ * Find the last checkpoint at or before a position.
+ */
+	static struct zpoint *
+zf_findpoint(zf, pos)
+	struct zfile *zf;
+	POSITION pos;
+{
+	int lo = 0;
+	int hi = zf->npoints;
+
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (zf->points[mid].out <= pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo > 0 ? &zf->points[lo-1] : NULL);
+}
+
+/*
+ * Start decompressing again from a checkpoint,
+ * or from the beginning of the file if p is NULL.
+ */
+	static int
+zf_restart(zf, f, p)
+	struct zfile *zf;
+	int f;
+	struct zpoint *p;
+{
+	unsigned long wlen;
+	unsigned char c;
+	long off;
+	long len;
+
+	if (zf->active)
+		inflateEnd(&zf->strm);
+	zf->active = FALSE;
+	memset(&zf->strm, 0, sizeof(zf->strm));
+	zf->skip = 0;
+	if (p == NULL)
+	{
+		if (inflateInit2(&zf->strm, 15+16) != Z_OK)
+			return (-1);
+		zf->active = TRUE;
+		zf->raw = FALSE;
+		zf->newmember = TRUE;
+		zf->in = zf->out = zf->low = 0;
+		return (0);
+	}
+
+	/*
+	 * Get the dictionary and the unused bits of the 
+	 * last partly used byte, and feed them to the decompressor.
+	 */
+	wlen = ZWINSIZE;
+	if (uncompress(zdict, &wlen, p->window, p->wsize) != Z_OK || 
+	    wlen != p->wlen)
+		return (-1);
+	if (p->bits && (lseek(f, (off_t)(p->in - 1), SEEK_SET) == BAD_LSEEK ||
+			read(f, &c, 1) != 1))
+		return (-1);
+	if (inflateInit2(&zf->strm, -15) != Z_OK)
+		return (-1);
+	zf->active = TRUE;
+	if (p->bits)
+		inflatePrime(&zf->strm, p->bits, c >> (8 - p->bits));
+	inflateSetDictionary(&zf->strm, zdict, (uInt) wlen);
+	zf->raw = TRUE;
+	zf->newmember = FALSE;
+	zf->in = p->in;
+
+	/*
+	 * The dictionary is the data just before the checkpoint;
+	 * put it in the history buffer.
+	 */
+	zf->out = p->out;
+	zf->low = p->out - wlen;
+	off = (long) (zf->low % zf->span);
+	len = zf->span - off;
+	if (len > (long) wlen)
+		len = (long) wlen;
+	memcpy(zf->hist + off, zdict, len);
+	memcpy(zf->hist, zdict + len, wlen - len);
+	return (0);
+}
+
+/*
+ * Decompress some more data into the history buffer.
+ * Return the number of bytes added to it, 0 at end of file, 
+ * or a negative number on error or interrupt.
+ */
+	static int
+zf_inflate(zf, f)
+	struct zfile *zf;
+	int f;
+{
+	long off;
+	int n;
+	int ret;
+
+	for (;;)
+	{
+		if (zf->strm.avail_in == 0)
+		{
+			if (lseek(f, (off_t)zf->in, SEEK_SET) == BAD_LSEEK)
+				return (-1);
+			n = iread(f, zf->inbuf, ZINSIZE);
+			if (n < 0)
+				return (n);
+			if (n == 0)
+			{
+				/*
+				 * End of file.  (If it isn't at the end 
+				 * of a gzip member, the file is truncated;
+				 * just show what we have.)
+				 */
+				zf->size = zf->out;
+				return (0);
+			}
+			zf->in += n;
+			zf->strm.next_in = zf->inbuf;
+			zf->strm.avail_in = n;
+		}
+		if (zf->skip > 0)
+		{
+			/*
+			 * Skip the trailer of a member which
+			 * we read in raw mode.
+			 */
+			n = (zf->strm.avail_in < (uInt) zf->skip) ? 
+				(int) zf->strm.avail_in : zf->skip;
+			zf->strm.next_in += n;
+			zf->strm.avail_in -= n;
+			zf->skip -= n;
+			continue;
+		}
+
+		off = (long) (zf->out % zf->span);
+		zf->strm.next_out = zf->hist + off;
+		zf->strm.avail_out = zf->span - off;
+		ret = inflate(&zf->strm, Z_BLOCK);
+		n = (zf->span - off) - zf->strm.avail_out;
+		zf->out += n;
+		if (zf->out - zf->low > zf->span)
+			zf->low = zf->out - zf->span;
+		if (n > 0)
+			zf->newmember = FALSE;
+
+		switch (ret)
+		{
+		case Z_OK:
+		case Z_BUF_ERROR:
+			/*
+			 * Save a checkpoint if we are at the end of
+			 * a block and far enough past the last one.
+			 */
+			if ((zf->strm.data_type & 128) && 
+			    !(zf->strm.data_type & 64) &&
+			    zf->out >= (zf->npoints > 0 ? 
+			    	zf->points[zf->npoints-1].out : 0) + zf->span)
+				zf_addpoint(zf);
+			break;
+		case Z_STREAM_END:
+			/*
+			 * End of a gzip member; another one may follow.
+			 */
+			if (zf->raw)
+				zf->skip = 8;
+			zf->raw = FALSE;
+			zf->newmember = TRUE;
+			if (inflateReset2(&zf->strm, 15+16) != Z_OK)
+				return (-1);
+			break;
+		default:
+			/*
+			 * Bad data.  If it follows a complete member, 
+			 * it's just junk after the end of the data.
+			 */
+			zf->size = zf->out;
+			return (zf->newmember ? 0 : -1);
+		}
+		if (n > 0)
+			return (n);
+	}
+}
+
+/*
+ * Read uncompressed data from a position in a compressed file.
+ * Return the number of bytes read, 0 at end of file, 
+ * or a negative number on error or interrupt.
+ */
+	static int
+zf_read(zf, f, pos, buf, len)
+	struct zfile *zf;
+	int f;
+	POSITION pos;
+	unsigned char *buf;
+	unsigned int len;
+{
+	struct zpoint *p;
+	long off;
+	int n;
+
+	for (;;)
+	{
+		if (pos >= zf->low && pos < zf->out)
+		{
+			/*
+			 * It's in the history buffer.
+			 */
+			off = (long) (pos % zf->span);
+			if (len > zf->out - pos)
+				len = (unsigned int) (zf->out - pos);
+			if (len > zf->span - off)
+				len = (unsigned int) (zf->span - off);
+			memcpy(buf, zf->hist + off, len);
+			return ((int) len);
+		}
+		if (zf->size != NULL_POSITION && pos >= zf->size)
+			return (0);
+		/*
+		 * Start again from a checkpoint if the position 
+		 * is behind us, or if the checkpoint is ahead of us.
+		 */
+		p = zf_findpoint(zf, pos);
+		if (!zf->active || pos < zf->low || 
+		    (p != NULL && p->out > zf->out))
+		{
+			if (zf_restart(zf, f, p) < 0)
+			{
+				zf->size = zf->out;
+				return (-1);
+			}
+		}
+		if (ABORT_SIGS())
+			return (READ_INTR);
+		if ((n = zf_inflate(zf, f)) <= 0)
+			return (n);
+	}
+}
+
+/*
+ * Return the size of the uncompressed data,
+ * decompressing all of it if necessary.
+ */
+	static POSITION
+zf_size(zf, f)
+	struct zfile *zf;
+	int f;
+{
+	static unsigned char buf[LBUFSIZE];
+	POSITION pos;
+
+	while (zf->size == NULL_POSITION)
+	{
+		pos = zf->out;
+		if (zf->npoints > 0 && zf->points[zf->npoints-1].out > pos)
+			pos = zf->points[zf->npoints-1].out;
+		if (zf_read(zf, f, pos, buf, sizeof(buf)) < 0 && 
+		    zf->size == NULL_POSITION)
+			return (NULL_POSITION);
+	}
+	return (zf->size);
+}
+#endif
+
 
 /*
  * Get the character pointed to by the read pointer.
@@ -153,6 +636,7 @@ ch_get()
 	register int h;
 	POSITION pos;
 	POSITION len;
+	double t;
 
 	if (thisfile == NULL)
 		return (EOI);
@@ -196,6 +680,7 @@ ch_get()
 		 * If the LRU buffer has data in it, 
 		 * then maybe allocate a new buffer.
 		 */
+		stat_ch_miss++;
 		if (ch_buftail == END_OF_CHAIN || 
 			bufnode_buf(ch_buftail)->block != -1)
 		{
@@ -205,7 +690,7 @@ ch_get()
 			 * 1. We can't seek on this file and -b is not in effect; or
 			 * 2. We haven't allocated the max buffers for this file yet.
 			 */
-			if ((autobuf && !(ch_flags & CH_CANSEEK)) ||
+			if ((autobuf && !(ch_flags & (CH_CANSEEK|CH_SPOOL))) ||
 				(maxbufs < 0 || ch_nbufs < maxbufs))
 				if (ch_addbuf())
 					/*
@@ -229,6 +714,27 @@ ch_get()
 		 */
 		return (EOI);
 
+	if ((ch_flags & CH_SPOOL) && pos < ch_fpos)
+	{
+		/*
+		 * This part of the pipe has already been read.
+		 * Get it back from the spool file.
+		 */
+		len = ch_fpos - pos;
+		if (len > LBUFSIZE - bp->datasize)
+			len = LBUFSIZE - bp->datasize;
+		if (lseek(fileno(ch_spool), (off_t)pos, SEEK_SET) == BAD_LSEEK ||
+		    (n = read(fileno(ch_spool), &bp->data[bp->datasize], 
+				(unsigned int) len)) <= 0)
+		{
+			error("spool file read error", NULL_PARG);
+			clear_eol();
+			return (EOI);
+		}
+		bp->datasize += n;
+		goto found;
+	}
+
 	if (pos != ch_fpos)
 	{
 		/*
@@ -238,6 +744,11 @@ ch_get()
 		 */
 		if (!(ch_flags & CH_CANSEEK))
 			return ('?');
+#if GZINPUT
+		if (ch_zfile != NULL)
+			; /* zf_read takes care of it */
+		else
+#endif
 		if (lseek(ch_file, (off_t)pos, SEEK_SET) == BAD_LSEEK)
 		{
  			error("seek error", NULL_PARG);
@@ -263,8 +774,26 @@ ch_get()
 		n = 1;
 	} else
 	{
+		/*
+		 * Reading a pipe may block for a long time,
+		 * so show what we have drawn so far.
+		 */
+		if (!(ch_flags & CH_CANSEEK))
+			flush();
+		STAT_START(t);
+#if GZINPUT
+		if (ch_zfile != NULL)
+			n = zf_read(ch_zfile, ch_file, ch_fpos, 
+				&bp->data[bp->datasize], 
+				(unsigned int)(LBUFSIZE - bp->datasize));
+		else
+#endif
 		n = iread(ch_file, &bp->data[bp->datasize], 
 			(unsigned int)(LBUFSIZE - bp->datasize));
+		STAT_END(t, stat_ch_time);
+		stat_ch_reads++;
+		if (n > 0)
+			stat_ch_bytes += n;
 	}
 
 	if (n == READ_INTR)
@@ -289,6 +818,21 @@ ch_get()
 		write(logfile, (char *) &bp->data[bp->datasize], n);
 #endif
 
+	if ((ch_flags & CH_SPOOL) && n > 0)
+	{
+		/*
+		 * Keep a copy of the data from the pipe in the spool file.
+		 * If that fails, just carry on without it.
+		 */
+		if (lseek(fileno(ch_spool), (off_t)ch_fpos, SEEK_SET) == BAD_LSEEK ||
+		    write(fileno(ch_spool), (char *) &bp->data[bp->datasize], n) != n)
+		{
+			fclose(ch_spool);
+			ch_spool = NULL;
+			ch_flags &= ~CH_SPOOL;
+		}
+	}
+
 	ch_fpos += n;
 	bp->datasize += n;
 
@@ -299,6 +843,18 @@ ch_get()
 	if (n == 0)
 	{
 		ch_fsize = pos;
+		if (ch_flags & CH_SPOOL)
+		{
+			/*
+			 * The pipe is finished, and the spool file 
+			 * has all of its data.  Read from the spool file 
+			 * from now on, and let it be seeked like a file.
+			 * (The pipe itself is closed by close_altfile.)
+			 */
+			ch_file = fileno(ch_spool);
+			ch_flags &= ~CH_SPOOL;
+			ch_flags |= CH_CANSEEK;
+		}
 		if (ignore_eoi)
 		{
 			/*
@@ -490,7 +1046,8 @@ ch_seek(pos)
 		return (1);
 
 	new_block = pos / LBUFSIZE;
-	if (!(ch_flags & CH_CANSEEK) && pos != ch_fpos && !buffered(new_block))
+	if (!(ch_flags & CH_CANSEEK) && pos != ch_fpos && !buffered(new_block) &&
+	    !((ch_flags & CH_SPOOL) && pos < ch_fpos))
 	{
 		if (ch_fpos > pos)
 			return (1);
@@ -518,10 +1075,21 @@ ch_seek(pos)
 ch_end_seek()
 {
 	POSITION len;
+	unsigned char *p;
+	char buf[INT_STRLEN_BOUND(POSITION)+2];
+	PARG parg;
+#if HAVE_TIME
+	time_type start;
+#endif
 
 	if (thisfile == NULL)
 		return (0);
 
+#if GZINPUT
+	if (ch_zfile != NULL)
+		ch_fsize = zf_size(ch_zfile, ch_file);
+	else
+#endif
 	if (ch_flags & CH_CANSEEK)
 		ch_fsize = filesize(ch_file);
 
@@ -530,11 +1098,27 @@ ch_end_seek()
 		return (ch_seek(len));
 
 	/*
-	 * Do it the slow way: read till end of data.
+	 * Do it the slow way: read till end of data,
+	 * a buffer at a time.  If it takes a while,
+	 * show how far we have got, no more than once a second.
 	 */
-	while (ch_forw_get() != EOI)
+#if HAVE_TIME
+	start = get_time();
+#endif
+	while (ch_forw_span(&p, (POSITION)LBUFSIZE) > 0)
+	{
 		if (ABORT_SIGS())
 			return (1);
+#if HAVE_TIME
+		if (get_time() > start)
+		{
+			postoa(ch_tell() / 1024, buf);
+			parg.p_string = buf;
+			ierror("Reading to end of input: %sK", &parg);
+			start = get_time();
+		}
+#endif
+	}
 	return (0);
 }
 
@@ -663,7 +1247,7 @@ ch_back_get()
 	{
 		if (ch_block <= 0)
 			return (EOI);
-		if (!(ch_flags & CH_CANSEEK) && !buffered(ch_block-1))
+		if (!(ch_flags & (CH_CANSEEK|CH_SPOOL)) && !buffered(ch_block-1))
 			return (EOI);
 		ch_block--;
 		ch_offset = LBUFSIZE-1;
@@ -671,6 +1255,69 @@ ch_back_get()
 	return (ch_get());
 }
 
+/*
+ * Get a run of characters starting at the read pointer,
+ * all from one buffer, and move the read pointer past them.
+ * Set *pp to point to them, and return how many there are 
+ * (no more than maxlen), or 0 at end of file.
+ */
+	public int
+ch_forw_span(pp, maxlen)
+	unsigned char **pp;
+	POSITION maxlen;
+{
+	static unsigned char c;
+	register struct buf *bp;
+	register int n;
+
+	if (thisfile == NULL || maxlen <= 0)
+		return (0);
+	n = ch_get();
+	if (n == EOI)
+		return (0);
+	bp = bufnode_buf(ch_bufhead);
+	if (bp->block != ch_block || ch_offset >= bp->datasize)
+	{
+		/*
+		 * The character didn't come from a buffer
+		 * (data lost from a pipe).
+		 */
+		c = n;
+		*pp = &c;
+		(void) ch_forw_get();
+		return (1);
+	}
+	n = bp->datasize - ch_offset;
+	if (n > maxlen)
+		n = (int) maxlen;
+	*pp = &bp->data[ch_offset];
+	ch_offset += n;
+	if (ch_offset >= LBUFSIZE)
+	{
+		ch_block++;
+		ch_offset = 0;
+	}
+	return (n);
+}
+
+/*
+ * Return a file descriptor from which the data of the current file
+ * can be read directly (so it can be copied without going through 
+ * the buffers), or -1 if there isn't one.
+ */
+	public int
+ch_rawfile()
+{
+	if (thisfile == NULL || ch_file < 0 || 
+	    (ch_flags & (CH_CANSEEK|CH_HELPFILE|CH_NODATA)) != CH_CANSEEK)
+		return (-1);
+#if GZINPUT
+	if (ch_zfile != NULL)
+		return (-1);
+#endif
+	return (ch_file);
+}
+
 /*
  * Set max amount of buffer space.
  * bufspace is in units of 1024 bytes.  -1 mean no limit.
@@ -720,8 +1367,31 @@ ch_flush()
 
 	/*
 	 * Figure out the size of the file, if we can.
+	 * For a compressed file, that's known only after 
+	 * it has all been read.  If it has changed, 
+	 * all the checkpoints are useless.
 	 */
+#if GZINPUT
+	if (ch_zfile != NULL)
+	{
+		if (zf_changed(ch_zfile, ch_file))
+		{
+			zf_close(ch_zfile);
+			thisfile->zfile = (void *) zf_open(ch_file);
+		}
+	}
+	if (ch_zfile != NULL)
+		ch_fsize = ch_zfile->size;
+	else
+#endif
 	ch_fsize = filesize(ch_file);
+#if HAVE_STAT
+	{
+		struct stat statbuf;
+		thisfile->mtime = (fstat(ch_file, &statbuf) == 0) ? 
+				statbuf.st_mtime : 0;
+	}
+#endif
 
 	/*
 	 * Seek to a known position: the beginning of the file.
@@ -737,7 +1407,11 @@ ch_flush()
 	 * data.  They are sometimes, but not always, seekable.
 	 * Force them to be non-seekable here.
 	 */
-	if (ch_fsize == 0)
+	if (ch_fsize == 0
+#if GZINPUT
+	    && ch_zfile == NULL
+#endif
+	    )
 	{
 		ch_fsize = NULL_POSITION;
 		ch_flags &= ~CH_CANSEEK;
@@ -846,10 +1520,75 @@ ch_set_eof()
 }
 
 
+/*
+ * Allocate and initialize a new filestate, and make it the current one.
+ */
+	static void
+new_filestate(f, flags)
+	int f;
+	int flags;
+{
+	thisfile = (struct filestate *) 
+			calloc(1, sizeof(struct filestate));
+	thisfile->buflist.next = thisfile->buflist.prev = END_OF_CHAIN;
+	thisfile->nbufs = 0;
+	thisfile->flags = 0;
+	thisfile->fpos = 0;
+	thisfile->block = 0;
+	thisfile->offset = 0;
+	thisfile->file = -1;
+	thisfile->fsize = NULL_POSITION;
+	thisfile->spool = NULL;
+	thisfile->zfile = NULL;
+	ch_flags = flags;
+	init_hashtbl();
+	/*
+	 * Try to seek; set CH_CANSEEK if it works.
+	 */
+	if ((flags & CH_CANSEEK) && !seekable(f))
+		ch_flags &= ~CH_CANSEEK;
+	/*
+	 * Make a spool file if a copy of the pipe is wanted.
+	 */
+	if ((flags & CH_SPOOL) && (thisfile->spool = tmpfile()) == NULL)
+		ch_flags &= ~CH_SPOOL;
+#if GZINPUT
+	/*
+	 * Decompress the file as it is read, if wanted.
+	 */
+	if ((ch_flags & CH_CANSEEK) && decompress)
+		thisfile->zfile = (void *) zf_open(f);
+#endif
+}
+
+/*
+ * Has the file changed since its buffers were last emptied?
+ */
+	static int
+ch_changed()
+{
+#if HAVE_STAT
+	struct stat statbuf;
+
+#if GZINPUT
+	if (ch_zfile != NULL)
+		return (zf_changed(ch_zfile, ch_file));
+#endif
+	if (ch_fsize == NULL_POSITION || fstat(ch_file, &statbuf) < 0)
+		return (TRUE);
+	return ((POSITION) statbuf.st_size != ch_fsize || 
+		statbuf.st_mtime != thisfile->mtime);
+#else
+	return (TRUE);
+#endif
+}
+
 /*
  * Initialize file state for a new file.
+ * Return TRUE if the buffers from an earlier ch_prefetch or ch_keep
+ * are still good (so other information about the file can be kept too).
  */
-	public void
+	public int
 ch_init(f, flags)
 	int f;
 	int flags;
@@ -860,31 +1599,155 @@ ch_init(f, flags)
 	thisfile = (struct filestate *) get_filestate(curr_ifile);
 	if (thisfile == NULL)
 	{
-		/*
-		 * Allocate and initialize a new filestate.
-		 */
-		thisfile = (struct filestate *) 
-				calloc(1, sizeof(struct filestate));
-		thisfile->buflist.next = thisfile->buflist.prev = END_OF_CHAIN;
-		thisfile->nbufs = 0;
-		thisfile->flags = 0;
-		thisfile->fpos = 0;
-		thisfile->block = 0;
-		thisfile->offset = 0;
-		thisfile->file = -1;
-		thisfile->fsize = NULL_POSITION;
-		ch_flags = flags;
-		init_hashtbl();
-		/*
-		 * Try to seek; set CH_CANSEEK if it works.
-		 */
-		if ((flags & CH_CANSEEK) && !seekable(f))
-			ch_flags &= ~CH_CANSEEK;
+		new_filestate(f, flags);
 		set_filestate(curr_ifile, (void *) thisfile);
 	}
 	if (thisfile->file == -1)
 		thisfile->file = f;
+	if (ch_flags & (CH_PREFETCHED|CH_KEPT))
+	{
+		/*
+		 * The buffers were filled before the file was edited
+		 * (by ch_prefetch, or when it was last edited).
+		 * Keep them, unless the file has changed since then.
+		 */
+		ch_flags &= ~(CH_PREFETCHED|CH_KEPT);
+		if (!(ch_flags & CH_CANSEEK))
+			return (TRUE);
+		if (!ch_changed() && lseek(ch_file, (off_t)0, SEEK_SET) != BAD_LSEEK)
+		{
+			ch_fpos = 0;
+			ch_block = 0;
+			ch_offset = 0;
+			return (TRUE);
+		}
+	}
+	ch_flush();
+	return (FALSE);
+}
+
+/*
+ * Set up the file state for a file other than the current one,
+ * and read up to "size" bytes from the start of it into buffers,
+ * so it can be displayed quickly when it is edited.
+ * Stop early if a key is typed; the rest is read when it is needed.
+ */
+	public void
+ch_prefetch(ifile, f, flags, size)
+	IFILE ifile;
+	int f;
+	int flags;
+	POSITION size;
+{
+	struct filestate *save_thisfile = thisfile;
+
+	new_filestate(f, flags);
+	ch_file = f;
 	ch_flush();
+	for (ch_block = 0;  ch_block * LBUFSIZE < size;  ch_block++)
+	{
+		if (ch_fsize != NULL_POSITION && ch_block * LBUFSIZE >= ch_fsize)
+			break;
+		ch_offset = 0;
+		if (ch_get() == EOI || sigs || tty_pending())
+			break;
+	}
+	ch_block = 0;
+	ch_offset = 0;
+	ch_flags |= CH_PREFETCHED;
+	set_filestate(ifile, (void *) thisfile);
+	thisfile = save_thisfile;
+}
+
+/*
+ * Is the file state of an ifile one set up by ch_prefetch?
+ */
+	public int
+ch_prefetched(ifile)
+	IFILE ifile;
+{
+	struct filestate *fs = (struct filestate *) get_filestate(ifile);
+
+	return (fs != NULL && (fs->flags & CH_PREFETCHED));
+}
+
+/*
+ * Throw away a file state set up by ch_prefetch or ch_keep,
+ * for a file which is not being edited.
+ */
+	public void
+ch_discard(ifile)
+	IFILE ifile;
+{
+	struct filestate *save_thisfile = thisfile;
+
+	thisfile = (struct filestate *) get_filestate(ifile);
+	if (thisfile != NULL && (ch_flags & (CH_PREFETCHED|CH_KEPT)))
+	{
+		ch_delbufs();
+		if (ch_file >= 0 && !(ch_flags & CH_POPENED))
+			close(ch_file);
+		if (ch_spool != NULL)
+			fclose(ch_spool);
+#if GZINPUT
+		if (ch_zfile != NULL)
+			zf_close(ch_zfile);
+#endif
+		free(thisfile);
+		set_filestate(ifile, (void *) NULL);
+	}
+	thisfile = save_thisfile;
+}
+
+/*
+ * Close the current file, like ch_close, but keep its buffers
+ * in case it is edited again.  Return FALSE (doing nothing, so the
+ * caller should ch_close it) if the file can't be reopened to the
+ * same data.
+ */
+	public int
+ch_keep()
+{
+	if (thisfile == NULL)
+		return (FALSE);
+	if ((ch_flags & (CH_CANSEEK|CH_POPENED|CH_HELPFILE|CH_KEEPOPEN)) != CH_CANSEEK)
+		return (FALSE);
+	close(ch_file);
+	ch_file = -1;
+	ch_flags |= CH_KEPT;
+	thisfile = NULL;
+	return (TRUE);
+}
+
+/*
+ * Return the file descriptor of the spool file of the current file,
+ * if it holds all of the data from the pipe, or -1 if not.
+ */
+	public int
+ch_spool_file()
+{
+	if (thisfile == NULL || ch_spool == NULL || !(ch_flags & CH_CANSEEK))
+		return (-1);
+	return (fileno(ch_spool));
+}
+
+/*
+ * Return the amount of buffer space (in K) used by a file.
+ */
+	public int
+ch_bufspace(ifile)
+	IFILE ifile;
+{
+	struct filestate *fs = (struct filestate *) get_filestate(ifile);
+
+	if (fs == NULL)
+		return (0);
+#if GZINPUT
+	if (fs->zfile != NULL)
+		return (fs->nbufs * (LBUFSIZE / 1024) + 
+			(int) (zf_space((struct zfile *) fs->zfile) / 1024));
+#endif
+	return (fs->nbufs * (LBUFSIZE / 1024));
 }
 
 /*
@@ -924,6 +1787,12 @@ ch_close()
 		/*
 		 * We don't even need to keep the filestate structure.
 		 */
+		if (ch_spool != NULL)
+			fclose(ch_spool);
+#if GZINPUT
+		if (ch_zfile != NULL)
+			zf_close(ch_zfile);
+#endif
 		free(thisfile);
 		thisfile = NULL;
 		set_filestate(curr_ifile, (void *) NULL);
@@ -69,6 +69,8 @@
 #define	A_GOEND_BUF		57
 #define	A_LLSHIFT		58
 #define	A_RRSHIFT		59
+#define	A_STATS			60
+#define	A_JUMP_KEY		61
 
 #define	A_INVALID		100
 #define	A_NOACTION		101
@@ -59,8 +59,13 @@ public char closequote = '"';
 #define HISTFILE_SEARCH_SECTION  ".search"
 #define HISTFILE_SHELL_SECTION   ".shell"
 
+/* Rewrite the history file when it has this many times LESSHISTSIZE entries */
+#define HISTFILE_COMPACT         4
+
 /*
  * A mlist structure represents a command history.
+ * The entries are also kept in a hash table by string,
+ * so a command can be found without searching the whole history.
  */
 struct mlist
 {
@@ -69,6 +74,10 @@ struct mlist
 	struct mlist *curr_mp;
 	char *string;
 	int modified;
+	struct mlist *hnext;	/* Next entry in hash chain */
+	struct mlist **hashtab;	/* Hash table (in list head only) */
+	int hashsize;		/* Size of hashtab (in list head only) */
+	int count;		/* Number of entries (in list head only) */
 };
 
 /*
@@ -136,6 +145,17 @@ clear_cmd()
 	updown_match = -1;
 }
 
+/*
+ * Start the command line again after the screen has been repainted,
+ * keeping the contents of the command buffer.
+ * The caller reprints the prompt and then calls cmd_redraw.
+ */
+	public void
+cmd_restart()
+{
+	cmd_col = prompt_col = 0;
+}
+
 /*
  * Display a string, usually as a prompt for input into the command buffer.
  */
@@ -297,6 +317,19 @@ cmd_repaint(old_cp)
 		cmd_left();
 }
 
+/*
+ * Redisplay the command buffer after the prompt,
+ * leaving the cursor where it was in the buffer.
+ */
+	public void
+cmd_redraw()
+{
+	char *save_cp = cp;
+
+	cp = &cmdbuf[cmd_offset];
+	cmd_repaint(save_cp);
+}
+
 /*
  * Put the cursor at "home" (just after the prompt),
  * and set cp to the corresponding char in cmdbuf.
@@ -717,6 +750,74 @@ cmd_updown(action)
 }
 #endif
 
+#if CMD_HISTORY
+/*
+ * Hash function for history strings.
+ */
+	static unsigned int
+mlist_hash(s, size)
+	char *s;
+	int size;
+{
+	unsigned int h = 0;
+
+	while (*s != '\0')
+		h = (h * 31) + (unsigned char) *s++;
+	return (h & (size - 1));
+}
+
+/*
+ * Add a new entry (already in the list) to the hash table of an mlist.
+ * If the table is full, make a bigger one.
+ */
+	static void
+mlist_addhash(mlist, new_ml)
+	struct mlist *mlist;
+	struct mlist *new_ml;
+{
+	struct mlist *ml;
+	unsigned int h;
+
+	if (mlist->count <= mlist->hashsize)
+	{
+		h = mlist_hash(new_ml->string, mlist->hashsize);
+		new_ml->hnext = mlist->hashtab[h];
+		mlist->hashtab[h] = new_ml;
+		return;
+	}
+	if (mlist->hashtab != NULL)
+		free(mlist->hashtab);
+	mlist->hashsize = (mlist->hashsize == 0) ? 64 : mlist->hashsize * 2;
+	mlist->hashtab = (struct mlist **) 
+		ecalloc(mlist->hashsize, sizeof(struct mlist *));
+	for (ml = mlist->next;  ml != mlist;  ml = ml->next)
+	{
+		h = mlist_hash(ml->string, mlist->hashsize);
+		ml->hnext = mlist->hashtab[h];
+		mlist->hashtab[h] = ml;
+	}
+}
+
+/*
+ * Find a string in an mlist.
+ */
+	static struct mlist *
+mlist_find(mlist, cmd)
+	struct mlist *mlist;
+	char *cmd;
+{
+	struct mlist *ml;
+
+	if (mlist->hashtab == NULL)
+		return (NULL);
+	for (ml = mlist->hashtab[mlist_hash(cmd, mlist->hashsize)];  
+	     ml != NULL;  ml = ml->hnext)
+		if (strcmp(ml->string, cmd) == 0)
+			return (ml);
+	return (NULL);
+}
+#endif
+
 /*
  * Add a string to an mlist.
  */
@@ -728,6 +829,7 @@ cmd_addhist(mlist, cmd, modified)
 {
 #if CMD_HISTORY
 	struct mlist *ml;
+	int is_new;
 	
 	/*
 	 * Don't save a trivial command.
@@ -742,17 +844,36 @@ cmd_addhist(mlist, cmd, modified)
 	ml = mlist->prev;
 	if (ml == mlist || strcmp(ml->string, cmd) != 0)
 	{
+		ml = mlist_find(mlist, cmd);
+		if (ml != NULL)
+		{
+			/*
+			 * The command is earlier in the history.
+			 * Move it to the end rather than keep two copies.
+			 */
+			ml->next->prev = ml->prev;
+			ml->prev->next = ml->next;
+			is_new = FALSE;
+		} else
+		{
+			/*
+			 * Did not find command in history.
+			 */
+			ml = (struct mlist *) ecalloc(1, sizeof(struct mlist));
+			ml->string = save(cmd);
+			mlist->count++;
+			is_new = TRUE;
+		}
 		/*
-		 * Did not find command in history.
-		 * Save the command and put it at the end of the history list.
+		 * Put the command at the end of the history list.
 		 */
-		ml = (struct mlist *) ecalloc(1, sizeof(struct mlist));
-		ml->string = save(cmd);
 		ml->modified = modified;
 		ml->next = mlist;
 		ml->prev = mlist->prev;
 		mlist->prev->next = ml;
 		mlist->prev = ml;
+		if (is_new)
+			mlist_addhash(mlist, ml);
 	}
 	/*
 	 * Point to the cmd just after the just-accepted command.
@@ -1334,17 +1455,8 @@ cmd_lastpattern()
 #endif
 
 #if CMD_HISTORY
-/*
- */
-	static int
-mlist_size(ml)
-	struct mlist *ml;
-{
-	int size = 0;
-	for (ml = ml->next;  ml->string != NULL;  ml = ml->next)
-		++size;
-	return size;
-}
+static long hist_fpos = 0;	/* Position in history file read up to (or -1) */
+static int hist_fentries = 0;	/* Number of entries in history file */
 
 /*
  * Get the name of the history file.
@@ -1387,34 +1499,65 @@ histfile_name()
 }
 
 /*
- * Read a .lesshst file and call a callback for each line in the file.
+ * Get the maximum number of entries to keep in each history list.
  */
-	static void
-read_cmdhist2(action, uparam, skip_search, skip_shell)
+	static int
+histsize()
+{
+	char *s;
+	int n = 0;
+
+	s = lgetenv("LESSHISTSIZE");
+	if (s != NULL)
+		n = atoi(s);
+	if (n <= 0)
+		n = 100;
+	return (n);
+}
+
+/*
+ * Read a .lesshst file, starting at a given position,
+ * and call a callback for each entry in the file.
+ * Return the position of the end of the file,
+ * or -1 if the file is not a history file.
+ *
+ * The file is a journal: each session appends the entries it added
+ * to the end of it, each group of entries preceded by a section line
+ * which says which history list they belong to.  So reading can start
+ * at any position which was once the end of the file.
+ */
+	static long
+read_cmdhist2(action, uparam, startpos)
 	void (*action)(void*,struct mlist*,char*);
 	void *uparam;
-	int skip_search;
-	int skip_shell;
+	long startpos;
 {
 	struct mlist *ml = NULL;
 	char line[CMDBUF_SIZE];
 	char *filename;
 	FILE *f;
 	char *p;
-	int *skip = NULL;
+	long endpos;
 
 	filename = histfile_name();
 	if (filename == NULL)
-		return;
+		return (startpos);
 	f = fopen(filename, "r");
 	free(filename);
 	if (f == NULL)
-		return;
-	if (fgets(line, sizeof(line), f) == NULL ||
-	    strncmp(line, HISTFILE_FIRST_LINE, strlen(HISTFILE_FIRST_LINE)) != 0)
+		return (startpos);
+	if (startpos == 0)
+	{
+		if (fgets(line, sizeof(line), f) == NULL ||
+		    strncmp(line, HISTFILE_FIRST_LINE, strlen(HISTFILE_FIRST_LINE)) != 0)
+		{
+			fclose(f);
+			return (-1);
+		}
+	} else if (fseek(f, startpos, SEEK_SET) != 0)
 	{
 		fclose(f);
-		return;
+		return (startpos);
 	}
 	while (fgets(line, sizeof(line), f) != NULL)
 	{
@@ -1429,39 +1572,23 @@ read_cmdhist2(action, uparam, skip_search, skip_shell)
 		if (strcmp(line, HISTFILE_SEARCH_SECTION) == 0)
 		{
 			ml = &mlist_search;
-			skip = &skip_search;
 		} else if (strcmp(line, HISTFILE_SHELL_SECTION) == 0)
 		{
 #if SHELL_ESCAPE || PIPEC
 			ml = &mlist_shell;
-			skip = &skip_shell;
 #else
 			ml = NULL;
-			skip = NULL;
 #endif
 		} else if (*line == '"')
 		{
+			hist_fentries++;
 			if (ml != NULL)
-			{
-				if (skip != NULL && *skip > 0)
-					--(*skip);
-				else
-					(*action)(uparam, ml, line+1);
-			}
+				(*action)(uparam, ml, line+1);
 		}
 	}
+	endpos = ftell(f);
 	fclose(f);
-}
-
-	static void
-read_cmdhist(action, uparam, skip_search, skip_shell)
-	void (*action)(void*,struct mlist*,char*);
-	void *uparam;
-	int skip_search;
-	int skip_shell;
-{
-	read_cmdhist2(action, uparam, skip_search, skip_shell);
-	(*action)(uparam, NULL, NULL); /* signal end of file */
+	return (endpos < 0 ? startpos : endpos);
 }
 
 	static void
@@ -1480,43 +1607,81 @@ addhist_init(void *uparam, struct mlist *ml, char *string)
 init_cmdhist()
 {
 #if CMD_HISTORY
-	read_cmdhist(&addhist_init, NULL, 0, 0);
+	hist_fpos = read_cmdhist2(&addhist_init, NULL, 0L);
 #endif /* CMD_HISTORY */
 }
 
+#if CMD_HISTORY
 /*
- * Write the header for a section of the history file.
+ * A buffer in which new contents of the history file are built.
+ */
+struct histbuf
+{
+	char *data;
+	int len;
+	int size;
+};
+
+/*
+ * Append a string (and optionally a prefix) to a histbuf.
  */
-#if CMD_HISTORY
 	static void
-write_mlist_header(ml, f)
-	struct mlist *ml;
-	FILE *f;
+histbuf_add(hb, prefix, s)
+	struct histbuf *hb;
+	char *prefix;
+	char *s;
 {
-	if (ml == &mlist_search)
-		fprintf(f, "%s\n", HISTFILE_SEARCH_SECTION);
-#if SHELL_ESCAPE || PIPEC
-	else if (ml == &mlist_shell)
-		fprintf(f, "%s\n", HISTFILE_SHELL_SECTION);
-#endif
+	int len = (int) (strlen(prefix) + strlen(s) + 1);
+	char *data;
+
+	if (hb->len + len > hb->size)
+	{
+		hb->size = (hb->size == 0) ? 1024 : hb->size * 2;
+		if (hb->size < hb->len + len)
+			hb->size = hb->len + len;
+		data = (char *) ecalloc(hb->size, sizeof(char));
+		if (hb->data != NULL)
+		{
+			memcpy(data, hb->data, hb->len);
+			free(hb->data);
+		}
+		hb->data = data;
+	}
+	SNPRINTF2(hb->data + hb->len, len + 1, "%s%s\n", prefix, s);
+	hb->len += len;
 }
 
 /*
- * Write all modified entries in an mlist to the history file.
+ * Write a section of the history file for an mlist to a histbuf:
+ * the last "max" entries in the list, or if max < 0, the modified ones.
  */
 	static void
-write_mlist(ml, f)
-	struct mlist *ml;
-	FILE *f;
+write_mlist(mlist, hb, max)
+	struct mlist *mlist;
+	struct histbuf *hb;
+	int max;
 {
-	for (ml = ml->next;  ml->string != NULL;  ml = ml->next)
+	struct mlist *ml;
+	int skip;
+
+	if (max < 0 && !mlist->modified)
+		return;
+	if (mlist == &mlist_search)
+		histbuf_add(hb, "", HISTFILE_SEARCH_SECTION);
+#if SHELL_ESCAPE || PIPEC
+	else if (mlist == &mlist_shell)
+		histbuf_add(hb, "", HISTFILE_SHELL_SECTION);
+#endif
+	skip = (max < 0) ? 0 : mlist->count - max;
+	for (ml = mlist->next;  ml != mlist;  ml = ml->next)
 	{
-		if (!ml->modified)
-			continue;
-		fprintf(f, "\"%s\n", ml->string);
+		if (skip > 0)
+			skip--;
+		else if (max >= 0 || ml->modified)
+			histbuf_add(hb, "\"", ml->string);
 		ml->modified = 0;
 	}
-	ml->modified = 0; /* entire mlist is now unmodified */
+	mlist->modified = 0; /* entire mlist is now unmodified */
 }
 
 /*
@@ -1533,77 +1698,30 @@ make_tempname(filename)
 	tempname[strlen(tempname)-1] = (lastch == 'Q') ? 'Z' : 'Q';
 	return tempname;
 }
-
-struct save_ctx
-{
-	struct mlist *mlist;
-	FILE *fout;
-};
-
-/*
- * Copy entries from the saved history file to a new file.
- * At the end of each mlist, append any new entries
- * created during this session.
- */
-	static void
-copy_hist(void *uparam, struct mlist *ml, char *string)
-{
-	struct save_ctx *ctx = (struct save_ctx *) uparam;
-
-	if (ml != ctx->mlist) {
-		/* We're changing mlists. */
-		if (ctx->mlist)
-			/* Append any new entries to the end of the current mlist. */
-			write_mlist(ctx->mlist, ctx->fout);
-		/* Write the header for the new mlist. */
-		ctx->mlist = ml;
-		write_mlist_header(ctx->mlist, ctx->fout);
-	}
-	if (string != NULL)
-	{
-		/* Copy the entry. */
-		fprintf(ctx->fout, "\"%s\n", string);
-	}
-	if (ml == NULL) /* End of file */
-	{
-		/* Write any sections that were not in the original file. */
-		if (mlist_search.modified)
-		{
-			write_mlist_header(&mlist_search, ctx->fout);
-			write_mlist(&mlist_search, ctx->fout);
-		}
-#if SHELL_ESCAPE || PIPEC
-		if (mlist_shell.modified)
-		{
-			write_mlist_header(&mlist_shell, ctx->fout);
-			write_mlist(&mlist_shell, ctx->fout);
-		}
-#endif
-	}
-}
 #endif /* CMD_HISTORY */
 
 /*
  * Make a file readable only by its owner.
  */
 	static void
-make_file_private(f)
-	FILE *f;
+make_file_private(fd)
+	int fd;
 {
 #if HAVE_FCHMOD
 	int do_chmod = 1;
 #if HAVE_STAT
 	struct stat statbuf;
-	int r = fstat(fileno(f), &statbuf);
+	int r = fstat(fd, &statbuf);
 	if (r < 0 || !S_ISREG(statbuf.st_mode))
 		/* Don't chmod if not a regular file. */
 		do_chmod = 0;
 #endif
 	if (do_chmod)
-		fchmod(fileno(f), 0600);
+		fchmod(fd, 0600);
 #endif
 }
 
+#if CMD_HISTORY
 /*
  * Does the history file need to be updated?
  */
@@ -1620,45 +1738,96 @@ histfile_modified()
 }
 
 /*
- * Update the .lesshst file.
+ * Append the entries added in this session to the history file.
+ * They are written with a single write, so entries from 
+ * sessions which exit at the same time don't get mixed up.
  */
-	public void
-save_cmdhist()
+	static int
+append_cmdhist(histname)
+	char *histname;
 {
-#if CMD_HISTORY
+	struct histbuf hb;
+	int f;
+	int r;
+
+#ifdef O_CREAT
+	f = open(histname, OPEN_APPEND|O_CREAT, 0600);
+#else
+	f = open(histname, OPEN_APPEND);
+	if (f < 0)
+		f = creat(histname, 0600);
+#endif
+	if (f < 0)
+		return (-1);
+	hb.data = NULL;
+	hb.len = hb.size = 0;
+	if (lseek(f, (off_t)0, SEEK_END) == 0)
+	{
+		/* New file. */
+		make_file_private(f);
+		histbuf_add(&hb, HISTFILE_FIRST_LINE, "");
+	}
+	write_mlist(&mlist_search, &hb, -1);
+#if SHELL_ESCAPE || PIPEC
+	write_mlist(&mlist_shell, &hb, -1);
+#endif
+	r = (write(f, hb.data, hb.len) == hb.len) ? 0 : -1;
+	close(f);
+	free(hb.data);
+	return (r);
+}
+
+/*
+ * Rewrite the history file, keeping only the last LESSHISTSIZE
+ * entries in each list, without duplicates.
+ */
+	static void
+compact_cmdhist(histname)
 	char *histname;
+{
+	struct histbuf hb;
 	char *tempname;
-	int skip_search;
-	int skip_shell;
-	struct save_ctx ctx;
-	char *s;
-	FILE *fout = NULL;
-	int histsize = 0;
+	FILE *fout;
+	int tries;
 
-	if (!histfile_modified())
-		return;
-	histname = histfile_name();
-	if (histname == NULL)
-		return;
 	tempname = make_tempname(histname);
-	fout = fopen(tempname, "w");
-	if (fout != NULL)
+	hb.data = NULL;
+	for (tries = 0;  tries < 3;  tries++)
 	{
-		make_file_private(fout);
-		s = lgetenv("LESSHISTSIZE");
-		if (s != NULL)
-			histsize = atoi(s);
-		if (histsize <= 0)
-			histsize = 100;
-		skip_search = mlist_size(&mlist_search) - histsize;
+		/*
+		 * Pick up any entries other sessions have appended
+		 * since we read the file.
+		 */
+		if (hist_fpos >= 0)
+			hist_fpos = read_cmdhist2(&addhist_init, NULL, hist_fpos);
+		hb.len = hb.size = 0;
+		if (hb.data != NULL)
+			free(hb.data);
+		hb.data = NULL;
+		histbuf_add(&hb, HISTFILE_FIRST_LINE, "");
+		write_mlist(&mlist_search, &hb, histsize());
 #if SHELL_ESCAPE || PIPEC
-		skip_shell = mlist_size(&mlist_shell) - histsize;
+		write_mlist(&mlist_shell, &hb, histsize());
 #endif
-		fprintf(fout, "%s\n", HISTFILE_FIRST_LINE);
-		ctx.fout = fout;
-		ctx.mlist = NULL;
-		read_cmdhist(copy_hist, &ctx, skip_search, skip_shell);
+		fout = fopen(tempname, "w");
+		if (fout == NULL)
+			break;
+		make_file_private(fileno(fout));
+		fwrite(hb.data, 1, hb.len, fout);
 		fclose(fout);
+		/*
+		 * If another session appended to the file meanwhile,
+		 * do it again, so its entries aren't lost.
+		 */
+#if HAVE_STAT
+		{
+			struct stat statbuf;
+			if (tries < 2 && hist_fpos >= 0 && 
+			    stat(histname, &statbuf) == 0 && 
+			    statbuf.st_size > hist_fpos)
+				continue;
+		}
+#endif
 #if MSDOS_COMPILER==WIN32C
 		/*
 		 * Windows rename doesn't remove an existing file,
@@ -1667,8 +1836,35 @@ save_cmdhist()
 		remove(histname);
 #endif
 		rename(tempname, histname);
+		break;
 	}
+	if (hb.data != NULL)
+		free(hb.data);
 	free(tempname);
+}
+#endif /* CMD_HISTORY */
+
+/*
+ * Update the .lesshst file.
+ * Usually the new entries are just appended to it,
+ * but when it gets too big it is rewritten.
+ */
+	public void
+save_cmdhist()
+{
+#if CMD_HISTORY
+	char *histname;
+
+	if (!histfile_modified())
+		return;
+	histname = histfile_name();
+	if (histname == NULL)
+		return;
+	if (hist_fpos < 0 || hist_fentries >= HISTFILE_COMPACT * histsize())
+		compact_cmdhist(histname);
+	else
+		(void) append_cmdhist(histname);
 	free(histname);
 #endif /* CMD_HISTORY */
 }
+
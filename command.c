@@ -38,6 +38,7 @@ extern int bs_mode;
 extern int show_attn;
 extern POSITION highest_hilite;
 extern char *every_first_cmd;
+extern char *statsfile;
 extern char *curr_altfilename;
 extern char version[];
 extern struct scrpos initial_scrpos;
@@ -56,6 +57,7 @@ extern int shift_count;
 extern int oldbot;
 extern int forw_prompt;
 extern int same_pos_bell;
+extern int incr_search;
 
 #if SHELL_ESCAPE
 static char *shellcmd = NULL;	/* For holding last shell command for "!!" */
@@ -82,7 +84,14 @@ struct ungot {
 };
 static struct ungot* ungot = NULL;
 
+static int incr_active;		/* In an incremental search? */
+static struct scrpos incr_scrpos; /* Screen position before it began */
+static char *incr_pattern;	/* Pattern last searched for */
+static int incr_type;		/* Search type last searched with */
+static int incr_result;		/* Result of that search */
+
 static void multi_search();
+static void search_prompt();
 
 /*
  * Move the cursor to start of prompt line before executing a command.
@@ -140,7 +149,17 @@ mca_search()
 
 	clear_bot();
 	clear_cmd();
+	search_prompt();
+	forw_prompt = 0;
+	set_mlist(ml_search, 0);
+}
 
+/*
+ * Display the prompt of a search command.
+ */
+	static void
+search_prompt()
+{
 	if (search_type & SRCH_NO_MATCH)
 		cmd_putstr("Non-match ");
 	if (search_type & SRCH_FIRST_FILE)
@@ -161,8 +180,107 @@ mca_search()
 		cmd_putstr("/");
 	else
 		cmd_putstr("?");
-	forw_prompt = 0;
-	set_mlist(ml_search, 0);
+}
+
+/*
+ * Start an incremental search, if they are enabled.
+ * Not done for commands which come from a string rather than the keyboard.
+ */
+	static void
+incr_begin()
+{
+	if (!incr_search || ungot != NULL)
+		return;
+	get_scrpos(&incr_scrpos);
+	if (incr_scrpos.pos == NULL_POSITION)
+		return;
+	incr_search_begin(search_type);
+	incr_pattern = NULL;
+	incr_result = 1;
+	incr_active = 1;
+}
+
+/*
+ * Return the screen to where it was before the incremental search began.
+ */
+	static void
+incr_restore()
+{
+	struct scrpos scrpos;
+
+	get_scrpos(&scrpos);
+	if (scrpos.pos != incr_scrpos.pos || scrpos.ln != incr_scrpos.ln)
+		jump_loc(incr_scrpos.pos, incr_scrpos.ln);
+}
+
+/*
+ * Finish an incremental search.
+ */
+	static void
+incr_end()
+{
+	incr_search_end();
+	if (incr_pattern != NULL)
+		free(incr_pattern);
+	incr_pattern = NULL;
+	incr_active = 0;
+}
+
+/*
+ * Abandon an incremental search, putting back the screen
+ * and the search pattern as they were before it began.
+ */
+	static void
+incr_cancel()
+{
+	incr_restore();
+	incr_search_undo();
+	incr_end();
+}
+
+/*
+ * Search for the pattern typed so far in an incremental search,
+ * and redisplay the command line over the (possibly moved) screen.
+ */
+	static void
+incr_step()
+{
+	char *cbuf = get_cmdbuf();
+	int type;
+
+	/*
+	 * Searches past the end of the current file could take a
+	 * long time, so those are left until the pattern is entered.
+	 */
+	type = search_type & ~(SRCH_PAST_EOF|SRCH_FIRST_FILE);
+	if (incr_pattern != NULL && strcmp(incr_pattern, cbuf) == 0 &&
+	    incr_type == type && incr_result >= 0)
+		return;
+	if (incr_pattern != NULL)
+		free(incr_pattern);
+	incr_pattern = save(cbuf);
+	incr_type = type;
+
+	if (*cbuf == '\0')
+	{
+		incr_restore();
+		incr_search_undo();
+		incr_result = 1;
+	} else
+	{
+		/*
+		 * Show the character just typed before searching.
+		 */
+		flush();
+		incr_result = incr_search_step(cbuf, type);
+		if (incr_result > 0)
+			incr_restore();
+	}
+	clear_bot();
+	cmd_restart();
+	search_prompt();
+	cmd_redraw();
+	flush();
 }
 
 /*
@@ -215,7 +333,22 @@ exec_mca()
 	{
 	case A_F_SEARCH:
 	case A_B_SEARCH:
-		multi_search(cbuf, (int) number, 0);
+		if (incr_active)
+		{
+			/*
+			 * If the last incremental search already found
+			 * this pattern, the screen is there already.
+			 * Otherwise search again from where it started.
+			 */
+			if (incr_result != 0 || incr_type != search_type ||
+			    number > 1 || strcmp(incr_pattern, cbuf) != 0)
+			{
+				incr_restore();
+				multi_search(cbuf, (int) number, 0);
+			}
+			incr_end();
+		} else
+			multi_search(cbuf, (int) number, 0);
 		break;
 #if HILITE_SEARCH
 	case A_FILTER:
@@ -240,6 +373,9 @@ exec_mca()
 		toggle_option(curropt, opt_lower, cbuf, optflag);
 		curropt = NULL;
 		break;
+	case A_JUMP_KEY:
+		jump_key(cbuf);
+		break;
 	case A_F_BRACKET:
 		match_brac(cbuf[0], cbuf[1], 1, (int) number);
 		break;
@@ -607,6 +743,9 @@ mca_char(c)
 		 */
 		return (MCA_DONE);
 
+	if (incr_active && (mca == A_F_SEARCH || mca == A_B_SEARCH))
+		incr_step();
+
 	if ((mca == A_F_BRACKET || mca == A_B_BRACKET) && len_cmdbuf() >= 2)
 	{
 		/*
@@ -868,7 +1007,10 @@ multi_search(pattern, n, silent)
 {
 	register int nomore;
 	IFILE save_ifile;
+	IFILE h;
 	int changed_file;
+	int skip;
+	int nmatch;
 
 	changed_file = 0;
 	save_ifile = save_curr_ifile();
@@ -924,12 +1066,29 @@ multi_search(pattern, n, silent)
 			 */
 			break;
 		/*
-		 * Move on to the next file.
+		 * Move on to the next file which may have a match,
+		 * passing over files which can be read directly and
+		 * have fewer matches than we still need.
 		 */
+		skip = 0;
+		h = curr_ifile;
+		for (;;)
+		{
+			h = (search_type & SRCH_FORW) ? next_ifile(h) : prev_ifile(h);
+			if (h == NULL_IFILE)
+				break;
+			nmatch = file_matches(get_filename(h), search_type, n);
+			if (nmatch < 0 || nmatch >= n)
+				break;
+			n -= nmatch;
+			skip++;
+		}
+		if (h == NULL_IFILE)
+			break;
 		if (search_type & SRCH_FORW)
-			nomore = edit_next(1);
+			nomore = edit_next(skip+1);
 		else
-			nomore = edit_prev(1);
+			nomore = edit_prev(skip+1);
 		if (nomore)
 			break;
 		changed_file = 1;
@@ -1034,6 +1193,13 @@ commands()
 				quit(QUIT_SAVED_STATUS);
 		}
 
+		/*
+		 * An incremental search which was not ended by
+		 * entering the pattern has been abandoned.
+		 */
+		if (incr_active)
+			incr_cancel();
+
 		/*
 		 * See if window size changed, for systems that don't
 		 * generate SIGWINCH.
@@ -1048,7 +1214,13 @@ commands()
 		if (sigs)
 			continue;
 		if (newaction == A_NOACTION)
+		{
+			if (idle_linenum())
+				/* The screen has changed; prompt again. */
+				continue;
+			prefetch();
 			c = getcc();
+		}
 
 	again:
 		if (sigs)
@@ -1347,6 +1519,17 @@ commands()
 			jump_line_loc((POSITION) number, jump_sline);
 			break;
 
+		case A_JUMP_KEY:
+			/*
+			 * Go to the first line with a given key
+			 * in a file sorted by key.
+			 */
+			if (ch_getflags() & CH_HELPFILE)
+				break;
+			start_mca(A_JUMP_KEY, "Key: ", (void*)NULL, 0);
+			c = getcc();
+			goto again;
+
 		case A_STAT:
 			/*
 			 * Print file name, etc.
@@ -1366,6 +1549,18 @@ commands()
 			dispversion();
 			break;
 
+		case A_STATS:
+			/*
+			 * Write performance statistics to the stats file.
+			 */
+			cmd_exec();
+			if (write_stats() == 0)
+			{
+				parg.p_string = statsfile;
+				error("Statistics written to %s", &parg);
+			}
+			break;
+
 		case A_QUIT:
 			/*
 			 * Exit.
@@ -1407,6 +1602,7 @@ commands()
 			if (number <= 0)
 				number = 1;
 			mca_search();
+			incr_begin();
 			c = getcc();
 			goto again;
 
@@ -1419,6 +1615,7 @@ commands()
 			if (number <= 0)
 				number = 1;
 			mca_search();
+			incr_begin();
 			c = getcc();
 			goto again;
 
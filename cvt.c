@@ -35,18 +35,35 @@ cvt_length(len, ops)
 }
 
 /*
- * Allocate a chpos array for use by cvt_text.
+ * Would cvt_text change a string?
+ * This errs on the side of saying yes: any non-ASCII byte counts.
  */
-	public int *
-cvt_alloc_chpos(len)
+	public int
+cvt_needed(src, len, ops)
+	char *src;
 	int len;
+	int ops;
 {
-	int i;
-	int *chpos = (int *) ecalloc(sizeof(int), len);
-	/* Initialize all entries to an invalid position. */
-	for (i = 0;  i < len;  i++)
-		chpos[i] = -1;
-	return (chpos);
+	char *src_end = src + len;
+	int c;
+
+	if (ops == 0)
+		return (0);
+	if ((ops & CVT_CRLF) && len > 0 && src_end[-1] == '\r')
+		return (1);
+	for ( ;  src < src_end;  src++)
+	{
+		c = *src;
+		if (c & 0x80)
+			return (1);
+		if ((ops & CVT_TO_LC) && ASCII_IS_UPPER(c))
+			return (1);
+		if ((ops & CVT_BS) && c == '\b')
+			return (1);
+		if ((ops & CVT_ANSI) && c == ESC)
+			return (1);
+	}
+	return (0);
 }
 
 /*
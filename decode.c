@@ -114,6 +114,7 @@ static unsigned char cmdtable[] =
 	'>',0,				A_GOEND,
 	SK(SK_END),0,			A_GOEND,
 	'P',0,				A_GOPOS,
+	ESC,'j',0,			A_JUMP_KEY,
 
 	'0',0,				A_DIGIT,
 	'1',0,				A_DIGIT,
@@ -130,6 +131,7 @@ static unsigned char cmdtable[] =
 	'=',0,				A_STAT,
 	CONTROL('G'),0,			A_STAT,
 	':','f',0,			A_STAT,
+	ESC,'=',0,			A_STATS,
 	'/',0,				A_F_SEARCH,
 	'?',0,				A_B_SEARCH,
 	ESC,'/',0,			A_F_SEARCH|A_EXTRA,	'*',0,
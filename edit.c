@@ -21,6 +21,11 @@ extern int cbufs;
 extern char *every_first_cmd;
 extern int any_display;
 extern int force_open;
+extern int prefetch_size;
+extern int prefetch_files;
+extern int keep_files;
+extern int keep_space;
+extern int spool_lessopen;
 extern int is_tty;
 extern int sigs;
 extern IFILE curr_ifile;
@@ -46,6 +51,31 @@ public ino_t curr_ino;
 char *curr_altfilename = NULL;
 static void *curr_altpipe;
 
+/*
+ * Files which have been opened by prefetch() but not yet edited.
+ */
+#define	NPREFETCH	8
+static struct prefetched {
+	IFILE pf_ifile;
+	char *pf_altfilename;	/* Alternate file from LESSOPEN */
+	void *pf_altpipe;
+} pflist[NPREFETCH];
+static int npf = 0;
+static IFILE pf_curr_ifile = NULL_IFILE;
+static int pf_done = 0;		/* Done all of them for pf_curr_ifile */
+
+/*
+ * Recently edited files whose buffers (see ch_keep), line numbers
+ * and hilites are kept, most recently edited first.
+ */
+#define	NKEPT		16
+static struct kept {
+	IFILE kf_ifile;
+	void *kf_linenum;	/* From save_linenum */
+	void *kf_hilite;	/* From save_hilite */
+} keptlist[NKEPT];
+static int nkept = 0;
+
 
 /*
  * Textlist functions deal with a list of words separated by spaces.
@@ -148,6 +178,83 @@ back_textlist(tlist, prev)
 	return (s);
 }
 
+/*
+ * Remove an entry from the list of kept files.
+ * If "use" is set, give its state back to the current file;
+ * otherwise throw it away.
+ */
+	static void
+unkeep(i, use)
+	int i;
+	int use;
+{
+	struct kept *kf = &keptlist[i];
+
+	if (use)
+	{
+		restore_linenum(kf->kf_linenum);
+	} else
+	{
+		ch_discard(kf->kf_ifile);
+		free(kf->kf_linenum);
+	}
+#if HILITE_SEARCH
+	restore_hilite(kf->kf_hilite, use);
+#endif
+	for (nkept--;  i < nkept;  i++)
+		keptlist[i] = keptlist[i+1];
+}
+
+/*
+ * Throw away the kept state of a file.
+ */
+	public void
+unkeep_ifile(ifile)
+	IFILE ifile;
+{
+	int i;
+
+	for (i = 0;  i < nkept;  i++)
+		if (keptlist[i].kf_ifile == ifile)
+		{
+			unkeep(i, 0);
+			return;
+		}
+}
+
+/*
+ * Add the current file to the front of the list of kept files.
+ * Then throw away the least recently edited ones 
+ * until the limits on the number of files and buffer space are met.
+ */
+	static void
+keep_ifile(ifile)
+	IFILE ifile;
+{
+	int i;
+	int space;
+
+	if (nkept >= NKEPT)
+		unkeep(NKEPT-1, 0);
+	for (i = nkept++;  i > 0;  i--)
+		keptlist[i] = keptlist[i-1];
+	keptlist[0].kf_ifile = ifile;
+	keptlist[0].kf_linenum = save_linenum();
+#if HILITE_SEARCH
+	keptlist[0].kf_hilite = save_hilite();
+#endif
+
+	space = 0;
+	for (i = 0;  i < nkept;  i++)
+	{
+		space += ch_bufspace(keptlist[i].kf_ifile);
+		if (i >= keep_files || (keep_space > 0 && space > keep_space))
+			break;
+	}
+	while (nkept > i)
+		unkeep(nkept-1, 0);
+}
+
 /*
  * Close the current input file.
  */
@@ -169,10 +276,20 @@ close_file()
 		store_pos(curr_ifile, &scrpos);
 		lastmark();
 	}
+	/*
+	 * If the file came through an input pipe,
+	 * its output may be worth keeping for next time.
+	 */
+	if (curr_altpipe != NULL)
+		opencache_spool(get_filename(curr_ifile));
 	/*
 	 * Close the file descriptor, unless it is a pipe.
+	 * Keep the buffers and other state of recently edited files.
 	 */
-	ch_close();
+	if (keep_files > 0 && ch_keep())
+		keep_ifile(curr_ifile);
+	else
+		ch_close();
 	/*
 	 * If we opened a file using an alternate name,
 	 * do special stuff to close it.
@@ -216,12 +333,14 @@ edit_ifile(ifile)
 	int answer;
 	int no_display;
 	int chflags;
+	int kept;
 	char *filename;
 	char *open_filename;
 	char *qopen_filename;
 	char *alt_filename;
 	void *alt_pipe;
 	IFILE was_curr_ifile;
+	int pf;
 	PARG parg;
 		
 	if (ifile == curr_ifile)
@@ -272,14 +391,30 @@ edit_ifile(ifile)
 	filename = save(get_filename(ifile));
 	/*
 	 * See if LESSOPEN specifies an "alternate" file to open.
+	 * If the file was opened by prefetch(), that has been done already.
 	 */
 	alt_pipe = NULL;
-	alt_filename = open_altfile(filename, &f, &alt_pipe);
+	for (pf = 0;  pf < npf && pflist[pf].pf_ifile != ifile;  pf++)
+		continue;
+	if (pf < npf)
+	{
+		alt_filename = pflist[pf].pf_altfilename;
+		alt_pipe = pflist[pf].pf_altpipe;
+		pflist[pf] = pflist[--npf];
+	} else
+		alt_filename = open_altfile(filename, &f, &alt_pipe);
 	open_filename = (alt_filename != NULL) ? alt_filename : filename;
 	qopen_filename = shell_unquote(open_filename);
 
 	chflags = 0;
-	if (alt_pipe != NULL)
+	if (ch_prefetched(ifile))
+	{
+		/*
+		 * The file state already holds the open file
+		 * and the start of its data.
+		 */
+		f = -1;
+	} else if (alt_pipe != NULL)
 	{
 		/*
 		 * The alternate "file" is actually a pipe.
@@ -287,8 +422,12 @@ edit_ifile(ifile)
 		 * in the call to open_altfile above.
 		 * Keep the file descriptor open because it was opened 
 		 * via popen(), and pclose() wants to close it.
+		 * If wanted, copy it to a spool file as it is read,
+		 * so it can be seeked.
 		 */
 		chflags |= CH_POPENED;
+		if (spool_lessopen)
+			chflags |= CH_SPOOL;
 	} else if (strcmp(open_filename, "-") == 0)
 	{
 		/* 
@@ -390,7 +529,7 @@ edit_ifile(ifile)
 	set_open(curr_ifile); /* File has been opened */
 	get_pos(curr_ifile, &initial_scrpos);
 	new_file = TRUE;
-	ch_init(f, chflags);
+	kept = ch_init(f, chflags);
 
 	if (!(chflags & CH_HELPFILE))
 	{
@@ -450,10 +589,191 @@ edit_ifile(ifile)
 			error("%s", &parg);
 		}
 	}
+	/*
+	 * If the file's buffers were kept, its line numbers 
+	 * and hilites can be used again too.
+	 */
+	for (pf = 0;  pf < nkept && keptlist[pf].kf_ifile != ifile;  pf++)
+		continue;
+	if (pf < nkept)
+		unkeep(pf, kept && is_tty);
 	free(filename);
 	return (0);
 }
 
+/*
+ * Open a file ahead of time, so that editing it later is quick.
+ * Return 0 if successful.
+ */
+	static int
+prefetch_ifile(ifile)
+	IFILE ifile;
+{
+	int f;
+	int chflags;
+	char *filename;
+	char *open_filename;
+	char *qopen_filename;
+	char *alt_filename;
+	void *alt_pipe;
+	char *m;
+
+	filename = get_filename(ifile);
+	if (strcmp(filename, "-") == 0 || 
+	    strcmp(filename, FAKE_HELPFILE) == 0 ||
+	    strcmp(filename, FAKE_EMPTYFILE) == 0)
+		return (-1);
+	/*
+	 * Running the input preprocessor means waiting for it,
+	 * with no way to notice a key typed meanwhile,
+	 * so leave that until the file is edited.
+	 */
+	if (altfile_uncached(filename))
+		return (-1);
+	alt_pipe = NULL;
+	alt_filename = open_altfile(filename, &f, &alt_pipe);
+	open_filename = (alt_filename != NULL) ? alt_filename : filename;
+	if (alt_pipe != NULL)
+	{
+		chflags = CH_POPENED;
+		if (spool_lessopen)
+			chflags |= CH_SPOOL;
+	} else if (strcmp(open_filename, "-") == 0 ||
+	           strcmp(open_filename, FAKE_EMPTYFILE) == 0)
+	{
+		goto fail;
+	} else if ((m = bad_file(open_filename)) != NULL)
+	{
+		/* Let edit_ifile complain about it. */
+		free(m);
+		goto fail;
+	} else
+	{
+		qopen_filename = shell_unquote(open_filename);
+		f = open(qopen_filename, OPEN_READ);
+		free(qopen_filename);
+		if (f < 0)
+			goto fail;
+		if (!force_open && !opened(ifile) && bin_file(f))
+		{
+			/* Let edit_ifile ask about it. */
+			close(f);
+			goto fail;
+		}
+		chflags = CH_CANSEEK;
+	}
+	ch_prefetch(ifile, f, chflags, (POSITION) prefetch_size * 1024);
+	pflist[npf].pf_ifile = ifile;
+	pflist[npf].pf_altfilename = alt_filename;
+	pflist[npf].pf_altpipe = alt_pipe;
+	npf++;
+	return (0);
+
+    fail:
+	if (alt_filename != NULL)
+	{
+		close_altfile(alt_filename, filename, alt_pipe);
+		free(alt_filename);
+	}
+	return (-1);
+}
+
+/*
+ * Close a file opened by prefetch() which is no longer wanted.
+ */
+	public void
+unprefetch_ifile(ifile)
+	IFILE ifile;
+{
+	int i;
+
+	for (i = 0;  i < npf;  i++)
+	{
+		if (pflist[i].pf_ifile != ifile)
+			continue;
+		ch_discard(ifile);
+		if (pflist[i].pf_altfilename != NULL)
+		{
+			close_altfile(pflist[i].pf_altfilename, 
+				get_filename(ifile), pflist[i].pf_altpipe);
+			free(pflist[i].pf_altfilename);
+		}
+		pflist[i] = pflist[--npf];
+		return;
+	}
+}
+
+/*
+ * While waiting for a command, open the files next to
+ * the current one in the command line list and read
+ * the start of each, so that :n and :p don't have to wait.
+ */
+	public void
+prefetch()
+{
+	IFILE want[NPREFETCH];
+	IFILE next;
+	IFILE prev;
+	int nwant;
+	int i, j;
+
+	if (curr_ifile == pf_curr_ifile && pf_done)
+		return;
+	pf_curr_ifile = curr_ifile;
+	pf_done = 0;
+
+	/*
+	 * Choose the files to prefetch:
+	 * alternately after and before the current one.
+	 */
+	nwant = 0;
+	next = prev = curr_ifile;
+	if (prefetch_size > 0 && curr_ifile != NULL_IFILE)
+	{
+		while (nwant < prefetch_files && nwant < NPREFETCH &&
+		       (next != NULL_IFILE || prev != NULL_IFILE))
+		{
+			if (next != NULL_IFILE && 
+			    (next = next_ifile(next)) != NULL_IFILE)
+				want[nwant++] = next;
+			if (nwant < prefetch_files && nwant < NPREFETCH &&
+			    prev != NULL_IFILE &&
+			    (prev = prev_ifile(prev)) != NULL_IFILE)
+				want[nwant++] = prev;
+		}
+	}
+
+	/*
+	 * Close the files which are no longer wanted,
+	 * then open the new ones.
+	 */
+	for (i = npf;  --i >= 0;  )
+	{
+		for (j = 0;  j < nwant && want[j] != pflist[i].pf_ifile;  j++)
+			continue;
+		if (j >= nwant)
+			unprefetch_ifile(pflist[i].pf_ifile);
+	}
+	if (nwant == 0)
+	{
+		pf_done = 1;
+		return;
+	}
+	flush();
+	for (j = 0;  j < nwant;  j++)
+	{
+		/*
+		 * Don't keep a command waiting;
+		 * finish the rest at the next prompt.
+		 */
+		if (sigs || tty_pending())
+			return;
+		if (get_filestate(want[j]) == NULL)
+			(void) prefetch_ifile(want[j]);
+	}
+	pf_done = 1;
+}
+
 /*
  * Edit a space-separated list of files.
  * For each filename in the list, enter it into the ifile list.
@@ -619,18 +939,11 @@ edit_index(n)
 {
 	IFILE h;
 
-	h = NULL_IFILE;
-	do
-	{
-		if ((h = next_ifile(h)) == NULL_IFILE)
-		{
-			/*
-			 * Reached end of the list without finding it.
-			 */
-			return (1);
-		}
-	} while (get_index(h) != n);
-
+	if ((h = index_ifile(n)) == NULL_IFILE)
+		/*
+		 * There is no such file in the list.
+		 */
+		return (1);
 	return (edit_ifile(h));
 }
 
@@ -45,6 +45,19 @@
 #define	S_ISREG(m)	(((m) & S_IFMT) == S_IFREG)
 #endif
 #endif
+#if HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#if HAVE_UTIME_H
+#include <utime.h>
+#endif
+
+/*
+ * The output of LESSOPEN can be kept in the LESSOPENCACHE directory
+ * between invocations of less.
+ */
+#define	OPENCACHE	(HAVE_POPEN && HAVE_STAT && HAVE_DIRENT_H)
+#define	OPENCACHE_SIZE	102400	/* Default limit on its size (K) */
 
 
 extern int force_open;
@@ -52,6 +65,7 @@ extern int secure;
 extern int use_lessopen;
 extern int ctldisp;
 extern int utf_mode;
+extern int decompress;
 extern IFILE curr_ifile;
 extern IFILE old_ifile;
 #if SPACES_IN_FILENAMES
@@ -483,6 +497,14 @@ bin_file(f)
 	n = read(f, data, sizeof(data));
 	if (n <= 0)
 		return (0);
+#if HAVE_ZLIB && HAVE_STAT
+	/*
+	 * A gzip file will be decompressed before it is displayed.
+	 */
+	if (decompress && n >= 2 && (data[0] & 0377) == 0x1f && 
+	    (data[1] & 0377) == 0x8b)
+		return (0);
+#endif
 	if (utf_mode)
 	{
 		bin_count = utf_bin_count(data, n);
@@ -839,6 +861,338 @@ num_pct_s(lessopen)
 	return (num);
 }
 
+#if OPENCACHE
+/*
+ * Return the key under which the output of LESSOPEN for a file
+ * is kept in the LESSOPENCACHE directory, or NULL if there is no cache.
+ * The key is made of the absolute name of the file (since LESSOPEN
+ * may choose what to do by the name), its identity, size and
+ * modification time, and the LESSOPEN string.
+ */
+	static char *
+opencache_key(filename)
+	char *filename;
+{
+	char *dir;
+	char *lessopen;
+	char *qfilename;
+	char *key;
+	char cwd[1024];
+	struct stat statbuf;
+	int len;
+	int n;
+
+	dir = lgetenv("LESSOPENCACHE");
+	lessopen = lgetenv("LESSOPEN");
+	if (secure || dir == NULL || *dir == '\0' || lessopen == NULL)
+		return (NULL);
+	qfilename = shell_unquote(filename);
+	if (stat(qfilename, &statbuf) < 0 || !S_ISREG(statbuf.st_mode))
+	{
+		free(qfilename);
+		return (NULL);
+	}
+	if (*qfilename == '/')
+		*cwd = '\0';
+	else if (getcwd(cwd, sizeof(cwd)) == NULL)
+	{
+		free(qfilename);
+		return (NULL);
+	} else
+		strcat(cwd, "/");
+	len = (int) (strlen(cwd) + strlen(qfilename) + strlen(lessopen) + 100);
+	key = (char *) ecalloc(len, sizeof(char));
+	SNPRINTF2(key, len, "%s%s\n", cwd, qfilename);
+	n = (int) strlen(key);
+	SNPRINTF4(key + n, len - n, "%lu %lu %ld %ld\n",
+		(unsigned long) statbuf.st_dev, (unsigned long) statbuf.st_ino,
+		(long) statbuf.st_size, (long) statbuf.st_mtime);
+	n += (int) strlen(key + n);
+	SNPRINTF1(key + n, len - n, "%s\n", lessopen);
+	free(qfilename);
+	return (key);
+}
+
+/*
+ * Return the name of the file in the LESSOPENCACHE directory which
+ * holds (or would hold) the output of LESSOPEN for a key.
+ * The key itself is kept in a file of the same name plus ".k",
+ * so that a different key with the same hash is not mistaken for it.
+ */
+	static char *
+opencache_name(key)
+	char *key;
+{
+	char *dir = lgetenv("LESSOPENCACHE");
+	char *name;
+	char *p;
+	unsigned int h1, h2;
+	int len;
+
+	h1 = 2166136261U;
+	h2 = 0;
+	for (p = key;  *p != '\0';  p++)
+	{
+		h1 = (h1 ^ (unsigned char) *p) * 16777619U;
+		h2 = h2 * 31 + (unsigned char) *p;
+	}
+	len = (int) strlen(dir) + 20;
+	name = (char *) ecalloc(len, sizeof(char));
+	SNPRINTF3(name, len, "%s/%08x%08x", dir, h1, h2);
+	return (name);
+}
+
+/*
+ * Return the name of the file which holds the key of a cached file.
+ */
+	static char *
+opencache_keyname(name)
+	char *name;
+{
+	int len = (int) strlen(name) + 3;
+	char *keyname = (char *) ecalloc(len, sizeof(char));
+
+	SNPRINTF1(keyname, len, "%s.k", name);
+	return (keyname);
+}
+
+/*
+ * Does the key file of a cached file hold the given key?
+ */
+	static int
+opencache_keymatch(name, key)
+	char *name;
+	char *key;
+{
+	char *keyname;
+	char *buf;
+	int len;
+	int f;
+	int n;
+
+	keyname = opencache_keyname(name);
+	f = open(keyname, OPEN_READ);
+	free(keyname);
+	if (f < 0)
+		return (0);
+	/* Read one more byte than the key, to catch a longer one. */
+	len = (int) strlen(key);
+	buf = (char *) ecalloc(len + 2, sizeof(char));
+	n = 0;
+	while (n <= len)
+	{
+		int r = read(f, buf + n, len + 1 - n);
+		if (r <= 0)
+			break;
+		n += r;
+	}
+	close(f);
+	n = (n == len && memcmp(buf, key, len) == 0);
+	free(buf);
+	return (n);
+}
+
+/*
+ * Is a file one of the files in the LESSOPENCACHE directory?
+ */
+	static int
+opencache_file(filename)
+	char *filename;
+{
+	char *dir = lgetenv("LESSOPENCACHE");
+	int len;
+
+	if (dir == NULL || *dir == '\0')
+		return (0);
+	len = (int) strlen(dir);
+	return (strncmp(filename, dir, len) == 0 && filename[len] == '/');
+}
+
+/*
+ * Return the name of the cached output of LESSOPEN for a file,
+ * or NULL if it is not in the cache.
+ */
+	static char *
+opencache_get(filename)
+	char *filename;
+{
+	char *key;
+	char *name;
+	struct stat statbuf;
+
+	key = opencache_key(filename);
+	if (key == NULL)
+		return (NULL);
+	name = opencache_name(key);
+	if (stat(name, &statbuf) < 0 || !S_ISREG(statbuf.st_mode) ||
+	    !opencache_keymatch(name, key))
+	{
+		free(name);
+		free(key);
+		return (NULL);
+	}
+	free(key);
+#if HAVE_UTIME_H
+	/* Mark it recently used. */
+	utime(name, (struct utimbuf *) NULL);
+#endif
+	return (name);
+}
+
+/*
+ * Remove the least recently used files from the LESSOPENCACHE directory
+ * until it is no bigger than LESSOPENCACHESIZE kilobytes.
+ */
+	static void
+opencache_trim(dir)
+	char *dir;
+{
+	DIR *d;
+	struct dirent *e;
+	struct stat statbuf;
+	char *name;
+	char *oldest;
+	time_type oldtime;
+	POSITION total;
+	POSITION limit;
+	char *s;
+	int len;
+
+	s = lgetenv("LESSOPENCACHESIZE");
+	limit = (POSITION) ((s != NULL && *s != '\0') ? atoi(s) : OPENCACHE_SIZE);
+	limit *= 1024;
+	if ((d = opendir(dir)) == NULL)
+		return;
+	len = (int) strlen(dir) + 256 + 2;
+	name = (char *) ecalloc(len, sizeof(char));
+	oldest = (char *) ecalloc(len, sizeof(char));
+	for (;;)
+	{
+		total = 0;
+		oldtime = 0;
+		*oldest = '\0';
+		while ((e = readdir(d)) != NULL)
+		{
+			/* Skip ".", ".." and partly written files. */
+			if (strlen(e->d_name) != 16)
+				continue;
+			SNPRINTF2(name, len, "%s/%s", dir, e->d_name);
+			if (stat(name, &statbuf) < 0 || !S_ISREG(statbuf.st_mode))
+				continue;
+			total += statbuf.st_size;
+			if (*oldest == '\0' || statbuf.st_mtime < oldtime)
+			{
+				strcpy(oldest, name);
+				oldtime = statbuf.st_mtime;
+			}
+		}
+		if (total <= limit || *oldest == '\0' || unlink(oldest) < 0)
+			break;
+		s = opencache_keyname(oldest);
+		unlink(s);
+		free(s);
+		rewinddir(d);
+	}
+	closedir(d);
+	free(oldest);
+	free(name);
+}
+
+/*
+ * Put a copy of the output of LESSOPEN for a file,
+ * read from the file descriptor f, into the cache.
+ */
+	static void
+opencache_put(filename, f)
+	char *filename;
+	int f;
+{
+	char *key;
+	char *name;
+	char *keyname;
+	char *tmpname;
+	char buf[8192];
+	int len;
+	int n;
+	int tf;
+
+	key = opencache_key(filename);
+	if (key == NULL)
+		return;
+	if (lseek(f, (off_t)0, SEEK_SET) == BAD_LSEEK)
+	{
+		free(key);
+		return;
+	}
+	name = opencache_name(key);
+	keyname = opencache_keyname(name);
+	/*
+	 * Write temporary files, then rename them,
+	 * so no other less can see them partly written.
+	 * The key goes first, so the output is never
+	 * found without it.
+	 */
+	len = (int) strlen(keyname) + 30;
+	tmpname = (char *) ecalloc(len, sizeof(char));
+	SNPRINTF2(tmpname, len, "%s.%ld", keyname, (long) getpid());
+	tf = open(tmpname, O_WRONLY|O_CREAT|O_TRUNC, 0600);
+	if (tf < 0)
+		goto done;
+	n = (int) strlen(key);
+	if (write(tf, key, n) != n || close(tf) < 0 ||
+	    rename(tmpname, keyname) < 0)
+	{
+		unlink(tmpname);
+		goto done;
+	}
+	SNPRINTF2(tmpname, len, "%s.%ld", name, (long) getpid());
+	tf = open(tmpname, O_WRONLY|O_CREAT|O_TRUNC, 0600);
+	if (tf >= 0)
+	{
+		while ((n = read(f, buf, sizeof(buf))) > 0)
+			if (write(tf, buf, n) != n)
+				break;
+		if (close(tf) < 0 || n != 0 || rename(tmpname, name) < 0)
+			unlink(tmpname);
+		else
+			opencache_trim(lgetenv("LESSOPENCACHE"));
+	}
+done:
+	free(tmpname);
+	free(keyname);
+	free(name);
+	free(key);
+}
+#endif
+
+/*
+ * Would open_altfile have to run the input preprocessor,
+ * rather than find its output in the cache?
+ */
+	public int
+altfile_uncached(filename)
+	char *filename;
+{
+#if !HAVE_POPEN
+	return (FALSE);
+#else
+#if OPENCACHE
+	char *cached;
+#endif
+
+	if (!use_lessopen || secure || lgetenv("LESSOPEN") == NULL)
+		return (FALSE);
+#if OPENCACHE
+	if ((cached = opencache_get(filename)) != NULL)
+	{
+		free(cached);
+		return (FALSE);
+	}
+#endif
+	return (TRUE);
+#endif
+}
+
 /*
  * See if we should open a "replacement file" 
  * instead of the file we're about to open.
@@ -893,6 +1247,13 @@ open_altfile(filename, pf, pfd)
 		error("Invalid LESSOPEN variable", NULL_PARG);
 		return (NULL);
 	}
+#if OPENCACHE
+	if ((cmd = opencache_get(filename)) != NULL)
+		/*
+		 * We have the output of LESSOPEN from last time.
+		 */
+		return (cmd);
+#endif
 
 	len = (int) (strlen(lessopen) + strlen(filename) + 2);
 	cmd = (char *) ecalloc(len, sizeof(char));
@@ -948,10 +1309,36 @@ open_altfile(filename, pf, pfd)
 		 * Pipe is empty.  This means there is no alt file.
 		 */
 		return (NULL);
+#if OPENCACHE
+	{
+		int f = open(cmd, OPEN_READ);
+		if (f >= 0)
+		{
+			opencache_put(filename, f);
+			close(f);
+		}
+	}
+#endif
 	return (cmd);
 #endif /* HAVE_POPEN */
 }
 
+/*
+ * If the whole output of the input pipe for the current file 
+ * has been spooled, put a copy of it in the LESSOPENCACHE directory.
+ */
+	public void
+opencache_spool(filename)
+	char *filename;
+{
+#if OPENCACHE
+	int f = ch_spool_file();
+
+	if (f >= 0)
+		opencache_put(filename, f);
+#endif
+}
+
 /*
  * Close a replacement file.
  */
@@ -969,6 +1356,13 @@ close_altfile(altfilename, filename, pipefd)
 	
 	if (secure)
 		return;
+#if OPENCACHE
+	if (opencache_file(altfilename))
+		/*
+		 * It's our own copy; LESSOPEN wasn't run this time.
+		 */
+		return;
+#endif
 	if (pipefd != NULL)
 	{
 #if OS2
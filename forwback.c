@@ -33,6 +33,9 @@ extern int ignore_eoi;
 extern int clear_bg;
 extern int final_attr;
 extern int oldbot;
+extern int squeeze;
+extern int chopline;
+extern int hshift;
 #if HILITE_SEARCH
 extern int size_linebuf;
 extern int hilite_search;
@@ -113,6 +116,22 @@ squish_check()
 	repaint();
 }
 
+/*
+ * Is each raw line in the file displayed as exactly one screen line?
+ * If so, we can find where lines start without formatting them.
+ */
+	static int
+raw_lines_ok()
+{
+	if (!(chopline || hshift > 0) || squeeze)
+		return (0);
+#if HILITE_SEARCH
+	if (is_filtering())
+		return (0);
+#endif
+	return (1);
+}
+
 /*
  * Display n lines, scrolling forward, 
  * starting at position pos in the input file.
@@ -132,6 +151,7 @@ forw(n, pos, force, only_last, nblank)
 {
 	int nlines = 0;
 	int do_repaint;
+	int raw_lines;
 	static int first_time = 1;
 
 	squish_check();
@@ -139,17 +159,19 @@ forw(n, pos, force, only_last, nblank)
 	/*
 	 * do_repaint tells us not to display anything till the end, 
 	 * then just repaint the entire screen.
-	 * We repaint if we are supposed to display only the last 
-	 * screenful and the request is for more than a screenful.
+	 * We repaint if the request is for more than a screenful,
+	 * since all but the last screenful would just scroll away.
 	 * Also if the request exceeds the forward scroll limit
 	 * (but not if the request is for exactly a screenful, since
 	 * repainting itself involves scrolling forward a screenful).
 	 */
-	do_repaint = (only_last && n > sc_height-1) || 
+	do_repaint = (n > sc_height-1) || 
 		(forw_scroll >= 0 && n > forw_scroll && n != sc_height-1);
+	raw_lines = do_repaint && raw_lines_ok();
 
 #if HILITE_SEARCH
-	if (hilite_search == OPT_ONPLUS || is_filtering() || status_col) {
+	if (hilite_search == OPT_ONPLUS || is_filtering() ||
+	    is_hiliting_words() || status_col) {
 		prep_hilite(pos, pos + 4*size_linebuf, ignore_eoi ? 1 : -1);
 		pos = next_unfiltered(pos);
 	}
@@ -212,8 +234,13 @@ forw(n, pos, force, only_last, nblank)
 		{
 			/* 
 			 * Get the next line from the file.
+			 * If we won't be displaying it, and don't need
+			 * to format it to know where it ends, just skip it.
 			 */
-			pos = forw_line(pos);
+			if (raw_lines)
+				pos = forw_raw_line(pos, (char **)NULL, (int *)NULL);
+			else
+				pos = forw_line(pos);
 #if HILITE_SEARCH
 			pos = next_unfiltered(pos);
 #endif
@@ -305,11 +332,18 @@ back(n, pos, force, only_last)
 {
 	int nlines = 0;
 	int do_repaint;
+	int raw_lines;
+	char **saved = NULL;
+	int nsaved = 0;
 
 	squish_check();
 	do_repaint = (n > get_back_scroll() || (only_last && n > sc_height-1));
+	raw_lines = do_repaint && raw_lines_ok();
+	if (!do_repaint && n > 0)
+		saved = (char **) ecalloc(n, sizeof(char *));
 #if HILITE_SEARCH
-	if (hilite_search == OPT_ONPLUS || is_filtering() || status_col) {
+	if (hilite_search == OPT_ONPLUS || is_filtering() ||
+	    is_hiliting_words() || status_col) {
 		prep_hilite((pos < 3*size_linebuf) ?  0 : pos - 3*size_linebuf, pos, -1);
 	}
 #endif
@@ -322,7 +356,10 @@ back(n, pos, force, only_last)
 		pos = prev_unfiltered(pos);
 #endif
 
-		pos = back_line(pos);
+		if (raw_lines)
+			pos = back_raw_line(pos, (char **)NULL, (int *)NULL);
+		else
+			pos = back_line(pos);
 		if (pos == NULL_POSITION)
 		{
 			/*
@@ -333,24 +370,44 @@ back(n, pos, force, only_last)
 		}
 		/*
 		 * Add the position of the previous line to the position table.
-		 * Display the line on the screen.
+		 * Keep the formatted line, to be displayed below.
 		 */
 		add_back_pos(pos);
+		if (saved != NULL)
+			saved[nsaved++] = save_line();
 		nlines++;
-		if (!do_repaint)
-		{
-			home();
-			add_line();
-			put_line();
-		}
 	}
 
 	if (nlines == 0 && same_pos_bell)
 		eof_bell();
 	else if (do_repaint)
 		repaint();
-	else if (!oldbot)
-		lower_left();
+	else
+	{
+		/*
+		 * Open up room for all the new lines at once,
+		 * then draw them from the top down.
+		 * Lines which would be pushed off the bottom
+		 * of the screen are not drawn at all.
+		 */
+		n = (nlines < sc_height-1) ? 0 : nlines - (sc_height-1);
+		home();
+		add_lines(nlines - n);
+		while (--nlines >= n)
+		{
+			restore_line(saved[nlines]);
+			put_line();
+		}
+		if (!oldbot)
+			lower_left();
+	}
+	if (saved != NULL)
+	{
+		for (n = 0;  n < nsaved;  n++)
+			if (saved[n] != NULL)
+				free(saved[n]);
+		free((char *) saved);
+	}
 	(void) currline(BOTTOM);
 }
 
@@ -2,6 +2,7 @@
 	public VOID_POINTER ecalloc ();
 	public char * skipsp ();
 	public int sprefix ();
+	public int write_stats ();
 	public void quit ();
 	public void raw_mode ();
 	public void scrsize ();
@@ -11,6 +12,7 @@
 	public void deinit ();
 	public void home ();
 	public void add_line ();
+	public void add_lines ();
 	public void remove_top ();
 	public void win32_scroll_up ();
 	public void lower_left ();
@@ -30,6 +32,7 @@
 	public void backspace ();
 	public void putbs ();
 	public char WIN32getch ();
+	public int tty_pending ();
 	public void WIN32setcolors ();
 	public void WIN32textout ();
 	public void match_brac ();
@@ -44,11 +47,19 @@
 	public POSITION ch_tell ();
 	public int ch_forw_get ();
 	public int ch_back_get ();
+	public int ch_forw_span ();
+	public int ch_rawfile ();
 	public void ch_setbufspace ();
 	public void ch_flush ();
 	public int seekable ();
 	public void ch_set_eof ();
-	public void ch_init ();
+	public int ch_init ();
+	public void ch_prefetch ();
+	public int ch_prefetched ();
+	public void ch_discard ();
+	public int ch_keep ();
+	public int ch_spool_file ();
+	public int ch_bufspace ();
 	public void ch_close ();
 	public int ch_getflags ();
 	public void ch_dump ();
@@ -69,8 +80,10 @@
 	public int is_combining_char ();
 	public void cmd_reset ();
 	public void clear_cmd ();
+	public void cmd_restart ();
 	public void cmd_putstr ();
 	public int len_cmdbuf ();
+	public void cmd_redraw ();
 	public void set_mlist ();
 	public void cmd_addhist ();
 	public void cmd_accept ();
@@ -87,7 +100,7 @@
 	public void ungetsc ();
 	public void commands ();
 	public int cvt_length ();
-	public int * cvt_alloc_chpos ();
+	public int cvt_needed ();
 	public void cvt_text ();
 	public void init_cmds ();
 	public void add_fcmd_table ();
@@ -101,8 +114,11 @@
 	public void init_textlist ();
 	public char * forw_textlist ();
 	public char * back_textlist ();
+	public void unkeep_ifile ();
 	public int edit ();
 	public int edit_ifile ();
+	public void unprefetch_ifile ();
+	public void prefetch ();
 	public int edit_list ();
 	public int edit_first ();
 	public int edit_last ();
@@ -124,7 +140,9 @@
 	public char * fcomplete ();
 	public int bin_file ();
 	public char * lglob ();
+	public int altfile_uncached ();
 	public char * open_altfile ();
+	public void opencache_spool ();
 	public void close_altfile ();
 	public int is_dir ();
 	public char * bad_file ();
@@ -147,6 +165,7 @@
 	public IFILE get_ifile ();
 	public char * get_filename ();
 	public int get_index ();
+	public IFILE index_ifile ();
 	public void store_pos ();
 	public void get_pos ();
 	public void set_open ();
@@ -166,6 +185,7 @@
 	public void jump_percent ();
 	public void jump_line_loc ();
 	public void jump_loc ();
+	public void jump_key ();
 	public void init_line ();
 	public int is_ascii_char ();
 	public void prewind ();
@@ -179,12 +199,19 @@
 	public void set_status_col ();
 	public int gline ();
 	public void null_line ();
+	public char * save_line ();
+	public void restore_line ();
 	public POSITION forw_raw_line ();
 	public POSITION back_raw_line ();
 	public int rrshift ();
 	public void clr_linenum ();
+	public void * save_linenum ();
+	public void restore_linenum ();
 	public void add_lnum ();
+	public void lazy_linenum ();
+	public int idle_linenum ();
 	public LINENUM find_linenum ();
+	public LINENUM find_linenum_within ();
 	public POSITION find_pos ();
 	public LINENUM currline ();
 	public void lsystem ();
@@ -206,6 +233,9 @@
 	public void opt_k ();
 	public void opt_t ();
 	public void opt__T ();
+	public void opt_stats_file ();
+	public void opt_jump_key ();
+	public void opt_highlight ();
 	public void opt_p ();
 	public void opt__P ();
 	public void opt_b ();
@@ -232,6 +262,7 @@
 	public int iread ();
 	public void intread ();
 	public time_type get_time ();
+	public double get_utime ();
 	public char * errno_message ();
 	public int percentage ();
 	public POSITION percent_pos ();
@@ -248,7 +279,11 @@
 	public void uncompile_pattern ();
 	public int valid_pattern ();
 	public int is_null_pattern ();
+	public int match_literal ();
 	public int match_pattern ();
+	public void * ac_compile ();
+	public void ac_free ();
+	public void ac_scan ();
 	public POSITION position ();
 	public void add_forw_pos ();
 	public void add_back_pos ();
@@ -271,16 +306,28 @@
 	public void clr_hlist ();
 	public void clr_hilite ();
 	public void clr_filter ();
+	public void * save_hilite ();
+	public void restore_hilite ();
 	public int is_filtered ();
 	public POSITION next_unfiltered ();
 	public POSITION prev_unfiltered ();
 	public int is_hilited ();
+	public int hilite_attr ();
 	public void chg_hilite ();
 	public void chg_caseless ();
+	public int file_matches ();
 	public int search ();
+	public void incr_search_begin ();
+	public int incr_search_step ();
+	public void incr_search_undo ();
+	public void incr_search_end ();
 	public void prep_hilite ();
 	public void set_filter_pattern ();
 	public int is_filtering ();
+	public int add_hword ();
+	public void clr_hwords ();
+	public int is_hiliting_words ();
+	public char * get_hword ();
 	public RETSIGTYPE winch ();
 	public RETSIGTYPE winch ();
 	public void init_signals ();
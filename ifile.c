@@ -17,6 +17,9 @@
  * appear on the command line.
  * Any new file which does not already appear in the list is
  * inserted after the current file.
+ * They are also kept in a hash table by filename, and the
+ * indexes are recomputed only when someone asks for one,
+ * so that a very long list of files can be built in linear time.
  */
 
 #include "less.h"
@@ -26,6 +29,7 @@ extern IFILE	curr_ifile;
 struct ifile {
 	struct ifile *h_next;		/* Links for command line list */
 	struct ifile *h_prev;
+	struct ifile *h_hnext;		/* Next in hash chain */
 	char *h_filename;		/* Name of the file */
 	void *h_filestate;		/* File state (used in ch.c) */
 	int h_index;			/* Index within command line list */
@@ -44,17 +48,78 @@ struct ifile {
 /*
  * Anchor for linked list.
  */
-static struct ifile anchor = { &anchor, &anchor, NULL, NULL, 0, 0, '\0',
+static struct ifile anchor = { &anchor, &anchor, NULL, NULL, NULL, 0, 0, '\0',
 				{ NULL_POSITION, 0 } };
 static int ifiles = 0;
 
+/*
+ * Hash table of ifiles, by filename.
+ */
+static struct ifile **hashtab = NULL;
+static int hashsize = 0;
+
+/*
+ * Table of ifiles by index, valid only if indexes_ok is set.
+ */
+static struct ifile **indextab = NULL;
+static int indexsize = 0;
+static int indexes_ok = 1;
+
+	static unsigned int
+hash_name(filename)
+	char *filename;
+{
+	register unsigned int h = 0;
+
+	while (*filename != '\0')
+		h = h * 31 + (unsigned char) *filename++;
+	return (h & (hashsize - 1));
+}
+
+/*
+ * Make the hash table bigger when it gets full.
+ */
 	static void
-incr_index(p, incr)
-	register struct ifile *p;
-	int incr;
+grow_hash()
+{
+	struct ifile *p;
+	unsigned int h;
+
+	if (hashtab != NULL)
+		free(hashtab);
+	hashsize = (hashsize == 0) ? 64 : hashsize * 2;
+	hashtab = (struct ifile **) ecalloc(hashsize, sizeof(struct ifile *));
+	for (p = anchor.h_next;  p != &anchor;  p = p->h_next)
+	{
+		h = hash_name(p->h_filename);
+		p->h_hnext = hashtab[h];
+		hashtab[h] = p;
+	}
+}
+
+/*
+ * Recompute the index of every ifile in the list.
+ */
+	static void
+renumber()
 {
-	for (;  p != &anchor;  p = p->h_next)
-		p->h_index += incr;
+	register struct ifile *p;
+	register int n;
+
+	if (indexsize < ifiles + 1)
+	{
+		if (indextab != NULL)
+			free(indextab);
+		indexsize = ifiles + 1 + ifiles / 2;
+		indextab = (struct ifile **) ecalloc(indexsize, sizeof(struct ifile *));
+	}
+	n = 0;
+	for (p = anchor.h_next;  p != &anchor;  p = p->h_next)
+	{
+		p->h_index = ++n;
+		indextab[n] = p;
+	}
+	indexes_ok = 1;
 }
 
 /*
@@ -75,12 +140,27 @@ link_ifile(p, prev)
 	prev->h_next->h_prev = p;
 	prev->h_next = p;
 	/*
-	 * Calculate index for the new one,
-	 * and adjust the indexes for subsequent ifiles in the list.
+	 * Adding to the end of the list leaves the existing 
+	 * indexes alone; otherwise they must be recomputed later.
 	 */
-	p->h_index = prev->h_index + 1;
-	incr_index(p->h_next, 1);
 	ifiles++;
+	if (indexes_ok && p->h_next == &anchor && ifiles < indexsize)
+	{
+		p->h_index = ifiles;
+		indextab[ifiles] = p;
+	} else
+		indexes_ok = 0;
+	/*
+	 * Link into hash table.
+	 */
+	if (ifiles > hashsize)
+		grow_hash();
+	else
+	{
+		unsigned int h = hash_name(p->h_filename);
+		p->h_hnext = hashtab[h];
+		hashtab[h] = p;
+	}
 }
 	
 /*
@@ -90,10 +170,15 @@ link_ifile(p, prev)
 unlink_ifile(p)
 	struct ifile *p;
 {
+	register struct ifile **pp;
+
 	p->h_next->h_prev = p->h_prev;
 	p->h_prev->h_next = p->h_next;
-	incr_index(p->h_next, -1);
+	for (pp = &hashtab[hash_name(p->h_filename)];  *pp != p;  pp = &(*pp)->h_hnext)
+		continue;
+	*pp = p->h_hnext;
 	ifiles--;
+	indexes_ok = 0;
 }
 
 /*
@@ -138,6 +223,8 @@ del_ifile(h)
 	 * move off it.
 	 */
 	unmark(h);
+	unprefetch_ifile(h);
+	unkeep_ifile(h);
 	if (h == curr_ifile)
 		curr_ifile = getoff_ifile(curr_ifile);
 	p = int_ifile(h);
@@ -210,7 +297,9 @@ find_ifile(filename)
 {
 	register struct ifile *p;
 
-	for (p = anchor.h_next;  p != &anchor;  p = p->h_next)
+	if (hashtab == NULL)
+		return (NULL);
+	for (p = hashtab[hash_name(filename)];  p != NULL;  p = p->h_hnext)
 		if (strcmp(filename, p->h_filename) == 0)
 			return (p);
 	return (NULL);
@@ -252,9 +341,25 @@ get_filename(ifile)
 get_index(ifile)
 	IFILE ifile;
 {
+	if (!indexes_ok)
+		renumber();
 	return (int_ifile(ifile)->h_index); 
 }
 
+/*
+ * Get the ifile with a given index.
+ */
+	public IFILE
+index_ifile(n)
+	int n;
+{
+	if (!indexes_ok)
+		renumber();
+	if (n < 1 || n > ifiles)
+		return (NULL_IFILE);
+	return (ext_ifile(indextab[n]));
+}
+
 /*
  * Save the file position to be associated with a given file.
  */
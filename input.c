@@ -20,6 +20,9 @@
 
 #include "less.h"
 
+public long stat_forw_line;	/* Number of calls to forw_line */
+public long stat_back_line;	/* Number of calls to back_line */
+
 extern int squeeze;
 extern int chopline;
 extern int hshift;
@@ -52,6 +55,7 @@ forw_line(curr_pos)
 	int endline;
 	int backchars;
 
+	stat_forw_line++;
 get_forw_line:
 	if (curr_pos == NULL_POSITION)
 	{
@@ -59,7 +63,8 @@ get_forw_line:
 		return (NULL_POSITION);
 	}
 #if HILITE_SEARCH
-	if (hilite_search == OPT_ONPLUS || is_filtering() || status_col)
+	if (hilite_search == OPT_ONPLUS || is_filtering() ||
+	    is_hiliting_words() || status_col)
 	{
 		/*
 		 * If we are ignoring EOI (command F), only prepare
@@ -257,6 +262,7 @@ back_line(curr_pos)
 	int endline;
 	int backchars;
 
+	stat_back_line++;
 get_back_line:
 	if (curr_pos == NULL_POSITION || curr_pos <= ch_zero())
 	{
@@ -264,7 +270,8 @@ get_back_line:
 		return (NULL_POSITION);
 	}
 #if HILITE_SEARCH
-	if (hilite_search == OPT_ONPLUS || is_filtering() || status_col)
+	if (hilite_search == OPT_ONPLUS || is_filtering() ||
+	    is_hiliting_words() || status_col)
 		prep_hilite((curr_pos < 3*size_linebuf) ? 
 				0 : curr_pos - 3*size_linebuf, curr_pos, -1);
 #endif
@@ -21,6 +21,15 @@ extern int screen_trashed;
 extern int sc_width, sc_height;
 extern int show_attn;
 extern int top_scroll;
+extern int linenums;
+extern int sigs;
+extern char *jump_key_pattern;
+
+/*
+ * When a key search has narrowed the file down to this many bytes,
+ * the remaining lines are read in order rather than bisected.
+ */
+#define	KEY_SCAN_SIZE	((POSITION)8192)
 
 /*
  * Jump to the end of the file.
@@ -49,6 +58,13 @@ jump_forw()
 	 */
 	pos_clear();
 	end_pos = ch_tell();
+	/*
+	 * Don't wait to count the lines in a large file before
+	 * showing its end.  Any line numbers which would take a while
+	 * to find are shown as unknown, and are filled in by
+	 * idle_linenum while less waits for the next command.
+	 */
+	lazy_linenum(1);
 	pos = back_line(end_pos);
 	if (pos == NULL_POSITION)
 		jump_loc((POSITION)0, sc_height-1);
@@ -58,6 +74,7 @@ jump_forw()
 		if (position(sc_height-1) != end_pos)
 			repaint();
 	}
+	lazy_linenum(0);
 }
 
 /*
@@ -331,3 +348,191 @@ jump_loc(pos, sline)
 		back(sc_height-1, pos, 1, 0);
 	}
 }
+
+/*
+ * Find the key of a line: the part of it matched by the --jump-key
+ * pattern, or the whole line if there is no such pattern.
+ * Return 0 if the line has no key.
+ */
+	static int
+line_key(pattern, line, line_len, kp, klenp)
+	void *pattern;
+	char *line;
+	int line_len;
+	char **kp;
+	int *klenp;
+{
+	char *sp, *ep;
+
+	if (jump_key_pattern == NULL)
+	{
+		*kp = line;
+		*klenp = line_len;
+		return (1);
+	}
+	if (!match_pattern(pattern, jump_key_pattern, line, line_len,
+			&sp, &ep, 0, 0))
+		return (0);
+	*kp = sp;
+	*klenp = (int) (ep - sp);
+	return (1);
+}
+
+/*
+ * Compare the key of a line with the key being sought.
+ * Only as much of the line's key as the sought key's length
+ * is compared, so "14:32" matches a line whose key is "14:32:05".
+ */
+	static int
+key_cmp(key, key_len, want, want_len)
+	char *key;
+	int key_len;
+	char *want;
+	int want_len;
+{
+	int n;
+	int r;
+
+	n = (key_len < want_len) ? key_len : want_len;
+	r = memcmp(key, want, n);
+	if (r != 0 || key_len >= want_len)
+		return (r);
+	return (-1);
+}
+
+/*
+ * Read forward from the line starting at pos, but not past limit,
+ * to the first line which has a key.
+ * Return the start of that line and set *cmpp to the result of
+ * comparing its key with the sought key, or return NULL_POSITION
+ * if there is no such line.
+ */
+	static POSITION
+next_keyed_line(pattern, pos, limit, want, want_len, cmpp)
+	void *pattern;
+	POSITION pos;
+	POSITION limit;
+	char *want;
+	int want_len;
+	int *cmpp;
+{
+	POSITION next;
+	char *line;
+	int line_len;
+	char *key;
+	int key_len;
+
+	while (pos < limit)
+	{
+		if (ABORT_SIGS())
+			return (NULL_POSITION);
+		next = forw_raw_line(pos, &line, &line_len);
+		if (next == NULL_POSITION)
+			return (NULL_POSITION);
+		if (line_key(pattern, line, line_len, &key, &key_len))
+		{
+			*cmpp = key_cmp(key, key_len, want, want_len);
+			return (pos);
+		}
+		pos = next;
+	}
+	return (NULL_POSITION);
+}
+
+/*
+ * Jump to the first line whose key is not less than a given key,
+ * in a file whose lines are sorted by key (e.g. a log file whose
+ * lines begin with timestamps).
+ * Rather than reading the whole file, probe the first line after
+ * the midpoint of the part of the file still in question,
+ * which takes a number of probes proportional to the logarithm
+ * of the file size.
+ */
+	public void
+jump_key(want)
+	char *want;
+{
+	void *pattern;
+	POSITION lo, hi, mid;
+	POSITION pos, found;
+	POSITION len;
+	int want_len;
+	int cmp;
+
+	want_len = (int) strlen(want);
+	if (want_len == 0)
+		return;
+	len = ch_length();
+	if (len == NULL_POSITION || !(ch_getflags() & CH_CANSEEK))
+	{
+		error("Cannot search a file which cannot seek", NULL_PARG);
+		return;
+	}
+	pattern = NULL;
+	if (jump_key_pattern != NULL &&
+	    compile_pattern(jump_key_pattern, 0, &pattern) < 0)
+		return;
+
+	/*
+	 * Every line starting before lo has a key less than the one
+	 * sought, and the line at found (if not len) has a key which
+	 * is not.  Only line starts before hi remain to be examined.
+	 */
+	lo = ch_zero();
+	hi = found = len;
+	while (hi - lo > KEY_SCAN_SIZE)
+	{
+		mid = lo + (hi - lo) / 2;
+		/*
+		 * Find the first line starting at or after mid.
+		 * Reading from mid-1 keeps a line which starts
+		 * exactly at mid.
+		 */
+		pos = forw_raw_line(mid-1, (char **)NULL, (int *)NULL);
+		if (pos == NULL_POSITION || pos >= hi)
+		{
+			/* No line starts between mid and hi. */
+			hi = mid;
+			continue;
+		}
+		pos = next_keyed_line(pattern, pos, hi, want, want_len, &cmp);
+		if (ABORT_SIGS())
+			break;
+		if (pos == NULL_POSITION)
+			/* No line between mid and hi has a key. */
+			hi = mid;
+		else if (cmp < 0)
+			lo = forw_raw_line(pos, (char **)NULL, (int *)NULL);
+		else
+			hi = found = pos;
+		if (lo == NULL_POSITION)
+			break;
+	}
+	if (!ABORT_SIGS() && lo != NULL_POSITION)
+	{
+		/*
+		 * Read the lines which remain in question.
+		 */
+		for (pos = lo;  pos < hi;  )
+		{
+			pos = next_keyed_line(pattern, pos, hi, want, want_len, &cmp);
+			if (pos == NULL_POSITION)
+				break;
+			if (cmp >= 0)
+			{
+				found = pos;
+				break;
+			}
+			pos = forw_raw_line(pos, (char **)NULL, (int *)NULL);
+		}
+	}
+	uncompile_pattern(&pattern);
+	if (ABORT_SIGS())
+		return;
+	if (found >= len)
+	{
+		error("No line with that key or a later one", NULL_PARG);
+		return;
+	}
+	jump_line_loc(found, jump_sline);
+}
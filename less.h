@@ -364,6 +364,7 @@ struct wchar_range_table
 #define SRCH_NO_REGEX   (1 << 12) /* Don't use regular expressions */
 #define SRCH_FILTER     (1 << 13) /* Search is for '&' (filter) command */
 #define SRCH_AFTER_TARGET (1 << 14) /* Start search after the target line */
+#define SRCH_INCR       (1 << 15) /* Start where the incremental search began */
 
 #define	SRCH_REVERSE(t)	(((t) & SRCH_FORW) ? \
 				(((t) & ~SRCH_FORW) | SRCH_BACK) : \
@@ -506,6 +507,9 @@ struct wchar_range_table
 #define	CH_POPENED	004
 #define	CH_HELPFILE	010
 #define	CH_NODATA  	020	/* Special case for zero length files */
+#define	CH_PREFETCHED	040	/* Opened by prefetch, not yet edited */
+#define	CH_KEPT		0100	/* Buffers kept after the file was closed */
+#define	CH_SPOOL	0200	/* Pipe is being copied to a spool file */
 
 
 #define	ch_zero()	((POSITION)0)
@@ -525,6 +529,13 @@ struct wchar_range_table
 #define	time_type	long
 #endif
 
+/*
+ * Accumulate the time spent in an operation
+ * into a statistics counter (see --stats-file).
+ */
+#define	STAT_START(t)		((t) = (statsfile != NULL) ? get_utime() : 0.0)
+#define	STAT_END(t,total)	((total) += (statsfile != NULL) ? get_utime() - (t) : 0.0)
+
 #include "funcs.h"
 
 /* Functions not included in funcs.h */
@@ -127,6 +127,7 @@ struct cmdname cmdnames[] =
 	{ "help",                 A_HELP },
 	{ "index-file",           A_INDEX_FILE },
 	{ "invalid",              A_UINVALID },
+	{ "jump-key",             A_JUMP_KEY },
 	{ "left-scroll",          A_LSHIFT },
 	{ "next-file",            A_NEXT_FILE },
 	{ "next-tag",             A_NEXT_TAG },
@@ -148,6 +149,7 @@ struct cmdname cmdnames[] =
 	{ "set-mark",             A_SETMARK },
 	{ "shell",                A_SHELL },
 	{ "status",               A_STAT },
+	{ "stats",                A_STATS },
 	{ "toggle-flag",          A_OPT_TOGGLE },
 	{ "toggle-option",        A_OPT_TOGGLE },
 	{ "undo-hilite",          A_UNDO_SEARCH },
@@ -209,7 +209,11 @@ plinenum(pos)
 		char buf[INT_STRLEN_BOUND(pos) + 2];
 		int n;
 
-		linenumtoa(linenum, buf);
+		if (linenum > 0)
+			linenumtoa(linenum, buf);
+		else
+			/* Not known (yet). */
+			strcpy(buf, "?");
 		n = (int) strlen(buf);
 		if (n < MIN_LINENUM_WIDTH)
 			n = MIN_LINENUM_WIDTH;
@@ -592,6 +596,12 @@ store_char(ch, a, rep, pos)
 				    	highest_hilite = pos;
 				a |= AT_HILITE;
 			}
+		} else if (a != AT_ANSI)
+		{
+			/*
+			 * Show a --highlight word in its own attribute.
+			 */
+			a |= hilite_attr(pos);
 		}
 	}
 #endif
@@ -1133,6 +1143,53 @@ null_line()
 	cshift = 0;
 }
 
+/*
+ * Return a copy of the current line (characters and attributes),
+ * so that it can be displayed later without being formatted again.
+ * Return NULL if there is no current line.
+ */
+	public char *
+save_line()
+{
+	int len;
+	char *p;
+
+	if (is_null_line)
+		return (NULL);
+	len = (int) strlen(linebuf);
+	p = (char *) ecalloc(2 * (len+1), sizeof(char));
+	memcpy(p, linebuf, len+1);
+	memcpy(p + len+1, attr, len+1);
+	return (p);
+}
+
+/*
+ * Make a line saved by save_line the current line again.
+ */
+	public void
+restore_line(p)
+	char *p;
+{
+	int len;
+
+	if (p == NULL)
+	{
+		null_line();
+		return;
+	}
+	len = (int) strlen(p);
+	while (len >= size_linebuf)
+		if (expand_linebuf())
+		{
+			null_line();
+			return;
+		}
+	memcpy(linebuf, p, len+1);
+	memcpy(attr, p + len+1, len+1);
+	curr = len;
+	is_null_line = 0;
+}
+
 /*
  * Analogous to forw_line(), but deals with "raw lines":
  * lines which are not split for screen width.
@@ -58,11 +58,18 @@ struct linenum_info
 #define	NPOOL	200			/* Size of line number pool */
 
 #define	LONGTIME	(2)		/* In seconds */
+#define	LAZYREAD	((POSITION)1024*1024)	/* See lazy_linenum */
 
 static struct linenum_info anchor;	/* Anchor of the list */
 static struct linenum_info *freelist;	/* Anchor of the unused entries */
 static struct linenum_info pool[NPOOL];	/* The pool itself */
 static struct linenum_info *spare;		/* We always keep one spare entry */
+static int lazy;			/* Don't read far to find line numbers */
+static POSITION lazy_pos = NULL_POSITION; /* Last one left unknown by lazy */
+
+public long stat_linenum_walks;	/* Number of times find_linenum read the file */
+public long stat_linenum_lines;	/* Number of lines it read to do so */
+public int linenum_gen;		/* Incremented whenever the cache is cleared */
 
 extern int linenums;
 extern int sigs;
@@ -95,6 +102,49 @@ clr_linenum()
 	anchor.gap = 0;
 	anchor.pos = (POSITION)0;
 	anchor.line = 1;
+	lazy_pos = NULL_POSITION;
+	linenum_gen++;
+}
+
+/*
+ * Save a copy of the line number cache, 
+ * so it can be restored if the current file is edited again.
+ */
+	public void *
+save_linenum()
+{
+	register struct linenum_info *p;
+	register struct linenum_info *s;
+	struct linenum_info *save;
+	int n;
+
+	n = 0;
+	for (p = anchor.next;  p != &anchor;  p = p->next)
+		n++;
+	save = (struct linenum_info *) ecalloc(n+1, sizeof(struct linenum_info));
+	for (p = anchor.next, s = save;  p != &anchor;  p = p->next, s++)
+	{
+		s->pos = p->pos;
+		s->line = p->line;
+	}
+	s->pos = NULL_POSITION;
+	return ((void *) save);
+}
+
+/*
+ * Restore the line number cache from a copy made by save_linenum,
+ * and free the copy.
+ */
+	public void
+restore_linenum(save)
+	void *save;
+{
+	register struct linenum_info *s;
+
+	clr_linenum();
+	for (s = (struct linenum_info *) save;  s->pos != NULL_POSITION;  s++)
+		add_lnum(s->line, s->pos);
+	free(save);
 }
 
 /*
@@ -257,6 +307,100 @@ abort_long()
 	error("Line numbers turned off", NULL_PARG);
 }
 
+/*
+ * Return how far a position is from the nearer of the cached
+ * line numbers on either side of it, given the first one after it.
+ */
+	static POSITION
+lnum_distance(p, pos)
+	struct linenum_info *p;
+	POSITION pos;
+{
+	POSITION dist;
+
+	dist = pos - p->prev->pos;
+	if (p != &anchor && p->pos - pos < dist)
+		dist = p->pos - pos;
+	return (dist);
+}
+
+/*
+ * Start or stop lazy line numbering.
+ * While it is on, find_linenum returns 0 rather than read more than
+ * LAZYREAD bytes of the file, so a screen far from any known line
+ * number can be displayed at once.  The line numbers left unknown
+ * are counted later by idle_linenum, and until then find_linenum
+ * stays lazy.
+ */
+	public void
+lazy_linenum(on)
+	int on;
+{
+	lazy = on;
+}
+
+/*
+ * While waiting for a command, count the lines up to the last
+ * position left unknown by lazy line numbering, LAZYREAD bytes
+ * at a time, stopping as soon as a key is typed.
+ * Return TRUE if the count was finished and the screen repainted.
+ */
+	public int
+idle_linenum()
+{
+	register struct linenum_info *p;
+	register LINENUM linenum;
+	POSITION cpos;
+	POSITION stop;
+
+	if (lazy_pos == NULL_POSITION)
+		return (FALSE);
+	if (linenums != OPT_ONPLUS)
+	{
+		/* No line numbers are displayed, so none are wanted. */
+		lazy_pos = NULL_POSITION;
+		return (FALSE);
+	}
+	/*
+	 * Show the screen as it is while counting.
+	 * Start from the last known line number before the position.
+	 */
+	flush();
+	for (p = anchor.next;  p != &anchor && p->pos <= lazy_pos;  p = p->next)
+		continue;
+	p = p->prev;
+	stat_linenum_walks++;
+	for (linenum = p->line, cpos = p->pos;  cpos < lazy_pos;  )
+	{
+		if (sigs || tty_pending())
+			/* Go on at the next prompt. */
+			return (FALSE);
+		if (ch_seek(cpos))
+		{
+			lazy_pos = NULL_POSITION;
+			return (FALSE);
+		}
+		for (stop = cpos + LAZYREAD;  cpos < lazy_pos && cpos < stop;  linenum++)
+		{
+			cpos = forw_raw_line(cpos, (char **)NULL, (int *)NULL);
+			stat_linenum_lines++;
+			if (cpos == NULL_POSITION)
+			{
+				lazy_pos = NULL_POSITION;
+				return (FALSE);
+			}
+		}
+		/*
+		 * Remember how far we got, in case a key is typed.
+		 */
+		add_lnum(linenum, cpos);
+	}
+
+	lazy_pos = NULL_POSITION;
+	repaint();
+	return (TRUE);
+}
+
 /*
  * Find the line number associated with a given position.
  * Return 0 if we can't figure it out.
@@ -293,6 +437,13 @@ find_linenum(pos)
 	if (p->pos == pos)
 		/* Found it exactly. */
 		return (p->line);
+	if ((lazy || lazy_pos != NULL_POSITION) &&
+	    lnum_distance(p, pos) > LAZYREAD)
+	{
+		if (lazy_pos == NULL_POSITION || pos > lazy_pos)
+			lazy_pos = pos;
+		return (0);
+	}
 
 	/*
 	 * This is the (possibly) time-consuming part.
@@ -308,6 +459,7 @@ find_linenum(pos)
 #if HAVE_TIME
 	startime = get_time();
 #endif
+	stat_linenum_walks++;
 	if (p == &anchor || pos - p->prev->pos < p->pos - pos)
 	{
 		/*
@@ -323,6 +475,7 @@ find_linenum(pos)
 			 * Allow a signal to abort this loop.
 			 */
 			cpos = forw_raw_line(cpos, (char **)NULL, (int *)NULL);
+			stat_linenum_lines++;
 			if (ABORT_SIGS()) {
 				abort_long();
 				return (0);
@@ -355,6 +508,7 @@ find_linenum(pos)
 			 * Allow a signal to abort this loop.
 			 */
 			cpos = back_raw_line(cpos, (char **)NULL, (int *)NULL);
+			stat_linenum_lines++;
 			if (ABORT_SIGS()) {
 				abort_long();
 				return (0);
@@ -372,6 +526,30 @@ find_linenum(pos)
 	return (linenum);
 }
 
+/*
+ * Like find_linenum, but give up and return 0 rather than
+ * read more than maxread bytes of the file to find the answer.
+ * A negative maxread means there is no limit.
+ */
+	public LINENUM
+find_linenum_within(pos, maxread)
+	POSITION pos;
+	POSITION maxread;
+{
+	register struct linenum_info *p;
+
+	if (!linenums || pos == NULL_POSITION)
+		return (0);
+	if (maxread >= 0 && pos > ch_zero())
+	{
+		for (p = anchor.next;  p != &anchor && p->pos < pos;  p = p->next)
+			continue;
+		if (lnum_distance(p, pos) > maxread)
+			return (0);
+	}
+	return (find_linenum(pos));
+}
+
 /*
  * Find the position of a given line number.
  * Return NULL_POSITION if we can't figure it out.
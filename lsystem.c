@@ -16,6 +16,12 @@
 #include "less.h"
 #include <signal.h>
 #include "position.h"
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#if HAVE_SENDFILE && HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 
 #if MSDOS_COMPILER
 #include <dos.h>
@@ -28,6 +34,7 @@
 #endif
 
 extern int screen_trashed;
+extern int sigs;
 extern IFILE curr_ifile;
 
 
@@ -279,6 +286,163 @@ pipe_mark(c, cmd)
  		return (pipe_data(cmd, tpos, mpos));
 }
 
+#define	PIPE_CHUNK	(1024*1024)	/* Amount to send between progress checks */
+
+/*
+ * Write all of a block of data to a file descriptor.
+ */
+	static int
+pipe_write(fd, buf, n)
+	int fd;
+	unsigned char *buf;
+	int n;
+{
+	int w;
+
+	while (n > 0)
+	{
+		w = write(fd, buf, n);
+		if (w < 0)
+		{
+#if HAVE_ERRNO
+			if (errno == EINTR && !ABORT_SIGS())
+				continue;
+#endif
+			return (-1);
+		}
+		buf += w;
+		n -= w;
+	}
+	return (0);
+}
+
+/*
+ * Show how much of the data has been sent to the pipe.
+ */
+	static void
+pipe_progress(done, total)
+	POSITION done;
+	POSITION total;
+{
+	char buf[INT_STRLEN_BOUND(POSITION)+2];
+
+	putchr('\r');
+	putstr("Piping: ");
+	if (total != NULL_POSITION && total > 0)
+	{
+		postoa((done * 100) / total, buf);
+		putstr(buf);
+		putstr("%");
+	} else
+	{
+		postoa(done / 1024, buf);
+		putstr(buf);
+		putstr("K");
+	}
+	putstr(" (interrupt to abort)");
+	flush();
+}
+
+/*
+ * Send the file contents from the read pointer (which is at spos)
+ * through epos, or to the end of the file if epos is NULL_POSITION,
+ * to a file descriptor.  Return the position after the last byte sent, 
+ * or NULL_POSITION if the pipe failed or we were interrupted.
+ */
+	static POSITION
+pipe_send(fd, spos, epos)
+	int fd;
+	POSITION spos;
+	POSITION epos;
+{
+	POSITION pos = spos;
+	POSITION total;
+	POSITION len;
+	POSITION chunk;
+	unsigned char *p;
+	int n;
+	int rawfd;
+	int shown = FALSE;
+	time_type start = get_time();
+
+	total = (epos != NULL_POSITION) ? epos - spos + 1 : 
+		(ch_length() != NULL_POSITION) ? ch_length() - spos : NULL_POSITION;
+	while (epos == NULL_POSITION || pos <= epos)
+	{
+		if (ABORT_SIGS())
+			return (NULL_POSITION);
+		/*
+		 * If the pipe is slow, show how far we have got,
+		 * no more than once a second.
+		 */
+		if (get_time() > start)
+		{
+			pipe_progress(pos - spos, total);
+			start = get_time();
+			shown = TRUE;
+		}
+		chunk = PIPE_CHUNK;
+		if (epos != NULL_POSITION && chunk > epos - pos + 1)
+			chunk = epos - pos + 1;
+
+#if HAVE_SENDFILE && HAVE_SYS_SENDFILE_H
+		/*
+		 * If the data can be read straight from the file,
+		 * let the system copy it to the pipe.
+		 */
+		if ((rawfd = ch_rawfile()) >= 0)
+		{
+			off_t off = (off_t) pos;
+			ssize_t r = sendfile(fd, rawfd, &off, (size_t) chunk);
+			if (r > 0)
+			{
+				pos += r;
+				continue;
+			}
+			if (r == 0)
+				break;
+#if HAVE_ERRNO
+			if (errno == EINTR)
+				continue;
+			if (errno != EINVAL && errno != ENOSYS)
+				return (NULL_POSITION);
+#endif
+			/*
+			 * sendfile doesn't work for this file;
+			 * go through the buffers instead.
+			 */
+			if (ch_seek(pos) != 0)
+				return (NULL_POSITION);
+		}
+#else
+		rawfd = -1;
+#endif
+		/*
+		 * Write the data a buffer at a time.
+		 */
+		for (len = 0;  len < chunk;  len += n)
+		{
+			n = ch_forw_span(&p, chunk - len);
+			if (n == 0)
+				break;
+			if (pipe_write(fd, p, n) < 0)
+				return (NULL_POSITION);
+		}
+		pos += len;
+		if (len < chunk)
+			break;
+	}
+	if (shown)
+	{
+		putchr('\r');
+		clear_eol();
+		flush();
+	}
+	if (ch_seek(pos) != 0)
+		return (NULL_POSITION);
+	return (pos);
+}
+
 /*
  * Create a pipe to the given shell command.
  * Feed it the file contents between the positions spos and epos.
@@ -291,6 +455,10 @@ pipe_data(cmd, spos, epos)
 {
 	register FILE *f;
 	register int c;
+	POSITION pos;
+	unsigned char *p;
+	unsigned char *nl;
+	int n;
 	extern FILE *popen();
 
 	/*
@@ -318,7 +486,6 @@ pipe_data(cmd, spos, epos)
 	deinit();
 	flush();
 	raw_mode(0);
-	init_signals(0);
 #if MSDOS_COMPILER==WIN32C
 	close_getchr();
 #endif
@@ -326,31 +493,33 @@ pipe_data(cmd, spos, epos)
 	LSIGNAL(SIGPIPE, SIG_IGN);
 #endif
 
-	c = EOI;
-	while (epos == NULL_POSITION || spos++ <= epos)
-	{
-		/*
-		 * Read a character from the file and give it to the pipe.
-		 */
-		c = ch_forw_get();
-		if (c == EOI)
-			break;
-		if (putc(c, f) == EOF)
-			break;
-	}
+	/*
+	 * Our signal handlers are left in place while the data is sent,
+	 * so an interrupt stops it.  We write to the file descriptor 
+	 * directly, in large blocks, rather than through stdio.
+	 */
+	pos = pipe_send(fileno(f), spos, epos);
 
 	/*
-	 * Finish up the last line.
+	 * Finish up the last line, a buffer at a time.
 	 */
- 	while (c != '\n' && c != EOI ) 
- 	{
- 		c = ch_forw_get();
- 		if (c == EOI)
- 			break;
- 		if (putc(c, f) == EOF)
- 			break;
- 	}
+	c = EOI;
+	if (pos != NULL_POSITION && pos > spos && ch_seek(pos-1) == 0)
+		c = ch_forw_get();
+	if (c != '\n' && c != EOI)
+	{
+		while (!ABORT_SIGS() &&
+		       (n = ch_forw_span(&p, (POSITION) PIPE_CHUNK)) > 0)
+		{
+			nl = (unsigned char *) memchr(p, '\n', n);
+			if (nl != NULL)
+				n = (int) (nl - p) + 1;
+			if (pipe_write(fileno(f), p, n) < 0 || nl != NULL)
+				break;
+		}
+	}
 
+	init_signals(0);
 	pclose(f);
 
 #ifdef SIGPIPE
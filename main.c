@@ -54,6 +54,18 @@ static char consoleTitle[256];
 #endif
 
 extern int	less_is_more;
+extern char *	statsfile;
+extern long	stat_ch_miss, stat_ch_reads;
+extern POSITION	stat_ch_bytes;
+extern double	stat_ch_time;
+extern long	stat_forw_line, stat_back_line;
+extern long	stat_search_lines;
+extern double	stat_search_time;
+extern long	stat_match_calls;
+extern long	stat_linenum_walks, stat_linenum_lines;
+extern POSITION	stat_out_bytes;
+extern long	stat_out_writes;
+extern double	stat_out_time;
 extern int	missing_cap;
 extern int	know_dumb;
 extern int	pr_type;
@@ -157,6 +169,13 @@ main(argc, argv)
 		quit(QUIT_OK);
 	}
 
+	if (statsfile == NULL && !secure)
+	{
+		s = lgetenv("LESSSTATS");
+		if (s != NULL && *s != '\0')
+			statsfile = save(s);
+	}
+
 #if EDITOR
 	editor = lgetenv("VISUAL");
 	if (editor == NULL || *editor == '\0')
@@ -368,6 +387,55 @@ sprefix(ps, s, uppercase)
 	return (len);
 }
 
+/*
+ * Append the performance statistics to the statistics file.
+ * Return 0 if they were written.
+ */
+	public int
+write_stats()
+{
+	FILE *f;
+	char buf[INT_STRLEN_BOUND(POSITION)+2];
+	PARG parg;
+
+	if (statsfile == NULL)
+	{
+		if (!quitting)
+			error("No statistics file", NULL_PARG);
+		return (-1);
+	}
+	f = fopen(statsfile, "a");
+	if (f == NULL)
+	{
+		if (!quitting)
+		{
+			parg.p_string = statsfile;
+			error("Cannot open statistics file %s", &parg);
+		}
+		return (-1);
+	}
+	fprintf(f, "less %s: %s\n", quitting ? "exit" : "stats",
+		(curr_ifile == NULL_IFILE) ? "-" : get_filename(curr_ifile));
+	fprintf(f, "  ch_get misses        %ld\n", stat_ch_miss);
+	fprintf(f, "  file reads           %ld\n", stat_ch_reads);
+	postoa(stat_ch_bytes, buf);
+	fprintf(f, "  bytes read           %s\n", buf);
+	fprintf(f, "  read time            %.6f\n", stat_ch_time);
+	fprintf(f, "  forw_line calls      %ld\n", stat_forw_line);
+	fprintf(f, "  back_line calls      %ld\n", stat_back_line);
+	fprintf(f, "  search lines         %ld\n", stat_search_lines);
+	fprintf(f, "  search time          %.6f\n", stat_search_time);
+	fprintf(f, "  pattern matches      %ld\n", stat_match_calls);
+	fprintf(f, "  line number walks    %ld\n", stat_linenum_walks);
+	fprintf(f, "  line number lines    %ld\n", stat_linenum_lines);
+	postoa(stat_out_bytes, buf);
+	fprintf(f, "  output bytes         %s\n", buf);
+	fprintf(f, "  output writes        %ld\n", stat_out_writes);
+	fprintf(f, "  output time          %.6f\n", stat_out_time);
+	fclose(f);
+	return (0);
+}
+
 /*
  * Exit the program.
  */
@@ -386,7 +454,10 @@ quit(status)
 	else
 		save_status = status;
 	quitting = 1;
+	(void) write_stats();
 	edit((char*)NULL);
+	/* With no current file, prefetch closes the files it opened. */
+	prefetch();
 	save_cmdhist();
 	if (any_display && is_tty)
 		clear_bot();
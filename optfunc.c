@@ -56,6 +56,8 @@ extern char *namelogfile;
 extern int force_logfile;
 extern int logfile;
 #endif
+public char *statsfile = NULL;
+public char *jump_key_pattern = NULL;
 #if TAGS
 public char *tagoption = NULL;
 extern char *tags;
@@ -356,6 +358,135 @@ opt__T(type, s)
 }
 #endif
 
+/*
+ * Handler for --stats-file option.
+ */
+	public void
+opt_stats_file(type, s)
+	int type;
+	char *s;
+{
+	PARG parg;
+
+	switch (type)
+	{
+	case INIT:
+	case TOGGLE:
+		if (secure)
+		{
+			error("Statistics file support is not available", NULL_PARG);
+			break;
+		}
+		s = skipsp(s);
+		if (statsfile != NULL)
+			free(statsfile);
+		statsfile = (*s == '\0') ? NULL : save(s);
+		break;
+	case QUERY:
+		if (statsfile == NULL)
+			error("No statistics file", NULL_PARG);
+		else
+		{
+			parg.p_string = statsfile;
+			error("Statistics file \"%s\"", &parg);
+		}
+		break;
+	}
+}
+
+/*
+ * Handler for the --jump-key option.
+ */
+	public void
+opt_jump_key(type, s)
+	int type;
+	char *s;
+{
+	PARG parg;
+
+	switch (type)
+	{
+	case INIT:
+	case TOGGLE:
+		if (*s != '\0' && !valid_pattern(s))
+		{
+			error("Invalid pattern", NULL_PARG);
+			break;
+		}
+		if (jump_key_pattern != NULL)
+			free(jump_key_pattern);
+		jump_key_pattern = (*s == '\0') ? NULL : save(s);
+		break;
+	case QUERY:
+		if (jump_key_pattern == NULL)
+			error("Line keys are whole lines", NULL_PARG);
+		else
+		{
+			parg.p_string = jump_key_pattern;
+			error("Line keys match \"%s\"", &parg);
+		}
+		break;
+	}
+}
+
+#if HILITE_SEARCH
+/*
+ * Handler for the --highlight option.
+ */
+	public void
+opt_highlight(type, s)
+	int type;
+	char *s;
+{
+	PARG parg;
+	char *words;
+	char *w;
+	int len;
+	int n;
+
+	switch (type)
+	{
+	case INIT:
+	case TOGGLE:
+		if (*s == '\0')
+		{
+			clr_hwords();
+			break;
+		}
+		if (!valid_pattern(s))
+		{
+			error("Invalid pattern", NULL_PARG);
+			break;
+		}
+		if (add_hword(s) < 0)
+			error("Too many highlight patterns", NULL_PARG);
+		break;
+	case QUERY:
+		if (get_hword(0) == NULL)
+		{
+			error("No highlight patterns", NULL_PARG);
+			break;
+		}
+		len = 1;
+		for (n = 0;  (w = get_hword(n)) != NULL;  n++)
+			len += (int) strlen(w) + 3;
+		words = (char *) ecalloc(1, len);
+		for (n = 0;  (w = get_hword(n)) != NULL;  n++)
+		{
+			if (n > 0)
+				strcat(words, " ");
+			strcat(words, "\"");
+			strcat(words, w);
+			strcat(words, "\"");
+		}
+		parg.p_string = words;
+		error("Highlighting %s", &parg);
+		free(words);
+		break;
+	}
+}
+#endif
+
 /*
  * Handler for -p option.
  */
@@ -505,6 +636,9 @@ opt__V(type, s)
 #if HAVE_PCRE
 		putstr("PCRE ");
 #endif
+#if HAVE_PCRE2
+		putstr("PCRE2 ");
+#endif
 #if HAVE_RE_COMP
 		putstr("BSD ");
 #endif
@@ -514,7 +648,7 @@ opt__V(type, s)
 #if HAVE_V8_REGCOMP
 		putstr("Spencer V8 ");
 #endif
-#if !HAVE_GNU_REGEX && !HAVE_POSIX_REGCOMP && !HAVE_PCRE && !HAVE_RE_COMP && !HAVE_REGCMP && !HAVE_V8_REGCOMP
+#if !HAVE_GNU_REGEX && !HAVE_POSIX_REGCOMP && !HAVE_PCRE && !HAVE_PCRE2 && !HAVE_RE_COMP && !HAVE_REGCMP && !HAVE_V8_REGCOMP
 		putstr("no ");
 #endif
 		putstr("regular expressions)\n");
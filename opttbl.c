@@ -53,6 +53,14 @@ public int quit_on_intr;	/* Quit on interrupt */
 public int follow_mode;		/* F cmd Follows file desc or file name? */
 public int oldbot;		/* Old bottom of screen behavior {{REMOVE}} */
 public int opt_use_backslash;	/* Use backslash escaping in option parsing */
+public int prefetch_size;	/* Amount of nearby files to read ahead (K) */
+public int prefetch_files;	/* Number of nearby files to read ahead */
+public int keep_files;		/* Number of closed files to keep buffers for */
+public int keep_space;		/* Buffer space for closed files (K) */
+public int spool_lessopen;	/* Copy LESSOPEN pipe output to a spool file */
+public int decompress;		/* Read gzip-compressed files directly */
+public int decompress_span;	/* Distance between decompressor checkpoints (K) */
+public int incr_search;		/* Search as the pattern is typed */
 #if HILITE_SEARCH
 public int hilite_search;	/* Highlight matched search patterns? */
 #endif
@@ -117,6 +125,19 @@ static struct optname keypad_optname = { "no-keypad",            NULL };
 static struct optname oldbot_optname = { "old-bot",              NULL };
 static struct optname follow_optname = { "follow-name",          NULL };
 static struct optname use_backslash_optname = { "use-backslash", NULL };
+static struct optname stats_optname  = { "stats-file",           NULL };
+static struct optname prefetch_optname = { "prefetch-size",      NULL };
+static struct optname prefetch_files_optname = { "prefetch-files", NULL };
+static struct optname keep_files_optname = { "keep-files",       NULL };
+static struct optname keep_space_optname = { "keep-space",       NULL };
+static struct optname spool_optname  = { "spool-lessopen",       NULL };
+static struct optname decompress_optname = { "decompress",       NULL };
+static struct optname decompress_span_optname = { "decompress-span", NULL };
+static struct optname jump_key_optname = { "jump-key",         NULL };
+static struct optname incsearch_optname = { "incsearch",       NULL };
+#if HILITE_SEARCH
+static struct optname highlight_optname = { "highlight",       NULL };
+#endif
 
 
 /*
@@ -456,6 +477,84 @@ static struct loption option[] =
 			NULL
 		}
 	},
+	{ OLETTER_NONE, &stats_optname,
+		STRING, 0, NULL, opt_stats_file,
+		{ "Statistics file: ", NULL, NULL }
+	},
+	{ OLETTER_NONE, &prefetch_optname,
+		NUMBER, 0, &prefetch_size, NULL,
+		{
+			"Read ahead in nearby files (K): ",
+			"Read ahead %dK in nearby files",
+			NULL
+		}
+	},
+	{ OLETTER_NONE, &prefetch_files_optname,
+		NUMBER, 2, &prefetch_files, NULL,
+		{
+			"Number of nearby files to read ahead: ",
+			"Read ahead in %d nearby files",
+			NULL
+		}
+	},
+	{ OLETTER_NONE, &keep_files_optname,
+		NUMBER, 0, &keep_files, NULL,
+		{
+			"Number of closed files to keep: ",
+			"Keep buffers of %d closed files",
+			NULL
+		}
+	},
+	{ OLETTER_NONE, &keep_space_optname,
+		NUMBER, 8192, &keep_space, NULL,
+		{
+			"Buffer space for closed files (K): ",
+			"Buffer space for closed files: %dK",
+			NULL
+		}
+	},
+	{ OLETTER_NONE, &spool_optname,
+		BOOL, OPT_OFF, &spool_lessopen, NULL,
+		{
+			"Don't spool LESSOPEN pipe output",
+			"Spool LESSOPEN pipe output",
+			NULL
+		}
+	},
+	{ OLETTER_NONE, &decompress_optname,
+		BOOL, OPT_OFF, &decompress, NULL,
+		{
+			"Don't decompress gzip files",
+			"Decompress gzip files",
+			NULL
+		}
+	},
+	{ OLETTER_NONE, &decompress_span_optname,
+		NUMBER, 4096, &decompress_span, NULL,
+		{
+			"Distance between decompression checkpoints (K): ",
+			"Decompression checkpoints every %dK",
+			NULL
+		}
+	},
+	{ OLETTER_NONE, &jump_key_optname,
+		STRING, 0, NULL, opt_jump_key,
+		{ "Pattern matching line keys: ", NULL, NULL }
+	},
+	{ OLETTER_NONE, &incsearch_optname,
+		BOOL, OPT_OFF, &incr_search, NULL,
+		{
+			"Search when the pattern is entered",
+			"Search as each character of the pattern is typed",
+			NULL
+		}
+	},
+#if HILITE_SEARCH
+	{ OLETTER_NONE, &highlight_optname,
+		STRING, 0, NULL, opt_highlight,
+		{ "Pattern to highlight: ", NULL, NULL }
+	},
+#endif
 	{ '\0', NULL, NOVAR, 0, NULL, NULL, { NULL, NULL, NULL } }
 };
 
@@ -26,6 +26,9 @@
 #if HAVE_TIME_H
 #include <time.h>
 #endif
+#if HAVE_GETTIMEOFDAY
+#include <sys/time.h>
+#endif
 #if HAVE_ERRNO_H
 #include <errno.h>
 #endif
@@ -108,7 +111,6 @@ start:
 		return (READ_INTR);
 	}
 
-	flush();
 	reading = 1;
 #if MSDOS_COMPILER==DJGPPC
 	if (isatty(fd))
@@ -195,6 +197,27 @@ get_time()
 }
 #endif
 
+/*
+ * Return the current time in seconds, as precisely as we can.
+ * Only differences between two values are meaningful.
+ */
+	public double
+get_utime()
+{
+#if HAVE_GETTIMEOFDAY
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (tv.tv_sec + tv.tv_usec / 1000000.0);
+#else
+#if HAVE_TIME
+	return ((double) get_time());
+#else
+	return (0.0);
+#endif
+#endif
+}
+
 
 #if !HAVE_STRERROR
 /*
@@ -21,6 +21,9 @@ public int errmsgs;	/* Count of messages displayed by error() */
 public int need_clr;
 public int final_attr;
 public int at_prompt;
+public POSITION stat_out_bytes;	/* Number of bytes written to the screen */
+public long stat_out_writes;	/* Number of writes to the screen */
+public double stat_out_time;	/* Time spent writing to the screen */
 
 extern int sigs;
 extern int sc_width;
@@ -29,6 +32,7 @@ extern int screen_trashed;
 extern int any_display;
 extern int is_tty;
 extern int oldbot;
+extern char *statsfile;
 
 #if MSDOS_COMPILER==WIN32C || MSDOS_COMPILER==BORLANDC || MSDOS_COMPILER==DJGPPC
 extern int ctldisp;
@@ -74,8 +78,40 @@ put_line()
 	at_exit();
 }
 
-static char obuf[OUTBUF_SIZE];
-static char *ob = obuf;
+/*
+ * The output buffer starts out as obuf_init[] and grows as needed
+ * while output is going to the screen, so that an entire screenful
+ * (lines, attribute changes and cursor motion) goes out in one write.
+ * Output to a non-terminal is just flushed whenever the buffer fills.
+ */
+static char obuf_init[OUTBUF_SIZE];
+static char *obuf = obuf_init;
+static int obuf_size = sizeof(obuf_init);
+static char *ob = obuf_init;
+
+/*
+ * Expand the output buffer.
+ */
+	static int
+expand_obuf()
+{
+	/* Double the size of the output buffer. */
+	int new_size = obuf_size * 2;
+	char *new_buf;
+
+	if (new_size > OUTBUF_MAX)
+		return 1;
+	new_buf = (char *) calloc(new_size, sizeof(char));
+	if (new_buf == NULL)
+		return 1;
+	memcpy(new_buf, obuf, ob - obuf);
+	ob = new_buf + (ob - obuf);
+	if (obuf != obuf_init)
+		free(obuf);
+	obuf = new_buf;
+	obuf_size = new_size;
+	return 0;
+}
 
 /*
  * Flush buffered output.
@@ -98,10 +134,13 @@ flush()
 {
 	register int n;
 	register int fd;
+	double t;
 
 	n = (int) (ob - obuf);
 	if (n == 0)
 		return;
+	stat_out_bytes += n;
+	stat_out_writes++;
 
 #if MSDOS_COMPILER==MSOFTC
 	if (is_tty && any_display)
@@ -372,8 +411,10 @@ flush()
 #endif
 #endif
 	fd = (any_display) ? 1 : 2;
+	STAT_START(t);
 	if (write(fd, obuf, n) != n)
 		screen_trashed = 1;
+	STAT_END(t, stat_out_time);
 	ob = obuf;
 }
 
@@ -423,9 +464,14 @@ putchr(c)
 	/*
 	 * Some versions of flush() write to *ob, so we must flush
 	 * when we are still one char from the end of obuf.
+	 * Rather than flush in the middle of drawing the screen,
+	 * try to make the buffer bigger.
 	 */
-	if (ob >= &obuf[sizeof(obuf)-1])
-		flush();
+	if (ob >= &obuf[obuf_size-1])
+	{
+		if (!(any_display && is_tty) || expand_obuf())
+			flush();
+	}
 	*ob++ = c;
 	at_prompt = 0;
 	return (c);
@@ -15,6 +15,17 @@
 #include "pattern.h"
 
 extern int caseless;
+extern int utf_mode;
+
+public long stat_match_calls;	/* Number of calls to match_pattern */
+
+#if HAVE_PCRE2
+/*
+ * Match data shared by all patterns and reused for every line.
+ * Only the extent of the whole match is needed.
+ */
+static pcre2_match_data *pcre2_mdata = NULL;
+#endif
 
 /*
  * Compile a search pattern, for future use by match_pattern.
@@ -77,6 +88,32 @@ compile_pattern2(pattern, search_type, comp_pattern, show_error)
 	}
 	*pcomp = comp;
 #endif
+#if HAVE_PCRE2
+	pcre2_code *comp;
+	pcre2_code **pcomp = (pcre2_code **) comp_pattern;
+	int errcode;
+	PCRE2_SIZE erroffset;
+	PCRE2_UCHAR errbuf[120];
+	PARG parg;
+	comp = pcre2_compile((PCRE2_SPTR) pattern, PCRE2_ZERO_TERMINATED, 0,
+			&errcode, &erroffset, NULL);
+	if (comp == NULL)
+	{
+		pcre2_get_error_message(errcode, errbuf, sizeof(errbuf));
+		parg.p_string = (char *) errbuf;
+		if (show_error)
+			error("%s", &parg);
+		return (-1);
+	}
+	/*
+	 * Compile the pattern to machine code if the library can.
+	 * If it can't, pcre2_match just uses the interpreter.
+	 */
+	(void) pcre2_jit_compile(comp, PCRE2_JIT_COMPLETE);
+	if (*pcomp != NULL)
+		pcre2_code_free(*pcomp);
+	*pcomp = comp;
+#endif
 #if HAVE_RE_COMP
 	PARG parg;
 	int *pcomp = (int *) comp_pattern;
@@ -116,7 +153,7 @@ compile_pattern2(pattern, search_type, comp_pattern, show_error)
 		return (-1);
 	}
 	if (*pcomp != NULL)
-		free(*pcomp);
+		regrelease(*pcomp);
 	*pcomp = comp;
 #endif
   }
@@ -173,6 +210,12 @@ uncompile_pattern(pattern)
 		pcre_free(*pcomp);
 	*pcomp = NULL;
 #endif
+#if HAVE_PCRE2
+	pcre2_code **pcomp = (pcre2_code **) pattern;
+	if (*pcomp != NULL)
+		pcre2_code_free(*pcomp);
+	*pcomp = NULL;
+#endif
 #if HAVE_RE_COMP
 	int *pcomp = (int *) pattern;
 	*pcomp = 0;
@@ -186,7 +229,7 @@ uncompile_pattern(pattern)
 #if HAVE_V8_REGCOMP
 	struct regexp **pcomp = (struct regexp **) pattern;
 	if (*pcomp != NULL)
-		free(*pcomp);
+		regrelease(*pcomp);
 	*pcomp = NULL;
 #endif
 }
@@ -225,6 +268,9 @@ is_null_pattern(pattern)
 #if HAVE_PCRE
 	return (pattern == NULL);
 #endif
+#if HAVE_PCRE2
+	return (pattern == NULL);
+#endif
 #if HAVE_RE_COMP
 	return (pattern == 0);
 #endif
@@ -239,34 +285,180 @@ is_null_pattern(pattern)
 #endif
 }
 
+/*
+ * Case folding table for one-byte characters, used by match.
+ * In UTF-8 mode only ASCII is folded through the table;
+ * other characters are decoded and folded one at a time.
+ */
+static unsigned char fold_table[256];
+static int fold_table_mode = -1;	/* utf_mode when fold_table was built */
+
+	static void
+init_fold_table()
+{
+	int c;
+	LWCHAR ch;
+
+	for (c = 0;  c < 256;  c++)
+	{
+		/* Fold the same way cvt_text would. */
+		ch = (LWCHAR) (char) c;
+		if ((c & 0x80) && utf_mode)
+			fold_table[c] = (unsigned char) c;
+		else if (IS_UPPER(ch))
+			fold_table[c] = (unsigned char) TO_LOWER(ch);
+		else
+			fold_table[c] = (unsigned char) c;
+	}
+	fold_table_mode = utf_mode;
+}
+
+/*
+ * Could skip_hidden skip anything at p?
+ */
+#define	MAY_BE_HIDDEN(p, end) \
+	(*(p) == ESC || (*(p) & 0x80) || *(p) == '\r' || \
+	 ((p) + 1 < (end) && (p)[1] == '\b'))
+
+/*
+ * Skip over text which cvt_text would remove from a line:
+ * ANSI escape sequences, a character followed by a backspace,
+ * and a CR at the end of the line.
+ */
+	static char *
+skip_hidden(p, end, ops)
+	char *p;
+	char *end;
+	int ops;
+{
+	char *q;
+	int len;
+
+	while (p < end)
+	{
+		if ((ops & CVT_ANSI) && (*p == ESC || (*p & 0x80)))
+		{
+			q = p;
+			if (IS_CSI_START(step_char(&q, +1, end)))
+			{
+				/* Skip to end of ANSI escape sequence. */
+				p = q + 1;
+				while (p < end)
+					if (!is_ansi_middle(*p++))
+						break;
+				if (p > end)
+					p = end;
+				continue;
+			}
+		}
+		if (ops & CVT_BS)
+		{
+			len = (utf_mode) ? utf_len(*p) : 1;
+			if (p + len < end && p[len] == '\b')
+			{
+				p += len + 1;
+				continue;
+			}
+		}
+		if ((ops & CVT_CRLF) && *p == '\r' && p + 1 == end)
+			return (end);
+		break;
+	}
+	return (p);
+}
+
 /*
  * Simple pattern matching function.
  * It supports no metacharacters like *, etc.
+ * The conversions in ops (see cvt_text) are applied to buf
+ * as it is scanned, so pfound and pend point into the original text.
  */
 	static int
-match(pattern, pattern_len, buf, buf_len, pfound, pend)
+match(pattern, pattern_len, buf, buf_len, pfound, pend, ops)
 	char *pattern;
 	int pattern_len;
 	char *buf;
 	int buf_len;
 	char **pfound, **pend;
+	int ops;
 {
 	register char *pp, *lp;
 	register char *pattern_end = pattern + pattern_len;
 	register char *buf_end = buf + buf_len;
+	register int cp, cl;
+	char *tp, *tl;
+	LWCHAR wp, wl;
+	int pfold = (caseless == OPT_ONPLUS || (ops & CVT_TO_LC));
+	int lfold = (ops & CVT_TO_LC);
+	int hidden = (ops & (CVT_BS|CVT_ANSI|CVT_CRLF));
+	int first = -1;
+
+	if (fold_table_mode != utf_mode)
+		init_fold_table();
+	/*
+	 * If the pattern starts with a one-byte char, look for that
+	 * byte before trying to match the rest of the pattern.
+	 */
+	if (pattern_len > 0 && !(utf_mode && (*pattern & 0x80)))
+	{
+		first = (unsigned char) *pattern;
+		if (pfold)
+			first = fold_table[first];
+	}
 
-	for ( ;  buf < buf_end;  buf++)
+	for ( ;  ;  buf += (utf_mode && (*buf & 0x80)) ? utf_len(*buf) : 1)
 	{
-		for (pp = pattern, lp = buf;  ;  pp++, lp++)
+		if (first >= 0)
 		{
-			char cp = *pp;
-			char cl = *lp;
-			if (caseless == OPT_ONPLUS && ASCII_IS_UPPER(cp))
-				cp = ASCII_TO_LOWER(cp);
-			if (cp != cl)
-				break;
-			if (pp == pattern_end || lp == buf_end)
+			for ( ;  buf < buf_end;  buf++)
+			{
+				cl = (unsigned char) *buf;
+				if ((ops & CVT_ANSI) && (cl == ESC || (cl & 0x80)))
+					break;
+				if (lfold)
+					cl = fold_table[cl];
+				if (cl == first && !((ops & CVT_BS) &&
+				    buf + 1 < buf_end && buf[1] == '\b'))
+					break;
+			}
+		}
+		if (hidden)
+			buf = skip_hidden(buf, buf_end, ops);
+		if (buf >= buf_end)
+			break;
+		for (pp = pattern, lp = buf;  pp < pattern_end;  )
+		{
+			if (hidden && lp < buf_end && MAY_BE_HIDDEN(lp, buf_end))
+				lp = skip_hidden(lp, buf_end, ops);
+			if (lp >= buf_end)
 				break;
+			cp = (unsigned char) *pp;
+			cl = (unsigned char) *lp;
+			if (utf_mode && ((cp | cl) & 0x80))
+			{
+				tp = pp;
+				tl = lp;
+				wp = step_char(&tp, +1, pattern_end);
+				wl = step_char(&tl, +1, buf_end);
+				if (pfold && IS_UPPER(wp))
+					wp = TO_LOWER(wp);
+				if (lfold && IS_UPPER(wl))
+					wl = TO_LOWER(wl);
+				if (wp != wl)
+					break;
+				pp = tp;
+				lp = tl;
+			} else
+			{
+				if (pfold)
+					cp = fold_table[cp];
+				if (lfold)
+					cl = fold_table[cl];
+				if (cp != cl)
+					break;
+				pp++;
+				lp++;
+			}
 		}
 		if (pp == pattern_end)
 		{
@@ -280,6 +472,32 @@ match(pattern, pattern_len, buf, buf_len, pfound, pend)
 	return (0);
 }
 
+/*
+ * Match a literal (SRCH_NO_REGEX) pattern against a line which
+ * has not been through cvt_text.  The conversions in ops are done
+ * while the line is scanned, so no converted copy is needed and
+ * sp and ep point into the original line.
+ */
+	public int
+match_literal(tpattern, line, line_len, sp, ep, ops, search_type)
+	char *tpattern;
+	char *line;
+	int line_len;
+	char **sp;
+	char **ep;
+	int ops;
+	int search_type;
+{
+	int matched;
+
+	stat_match_calls++;
+	*sp = *ep = NULL;
+	matched = match(tpattern, strlen(tpattern), line, line_len, sp, ep, ops);
+	matched = (!(search_type & SRCH_NO_MATCH) && matched) ||
+			((search_type & SRCH_NO_MATCH) && !matched);
+	return (matched);
+}
+
 /*
  * Perform a pattern match with the previously compiled pattern.
  * Set sp and ep to the start and end of the matched string.
@@ -305,6 +523,9 @@ match_pattern(pattern, tpattern, line, line_len, sp, ep, notbol, search_type)
 #if HAVE_PCRE
 	pcre *spattern = (pcre *) pattern;
 #endif
+#if HAVE_PCRE2
+	pcre2_code *spattern = (pcre2_code *) pattern;
+#endif
 #if HAVE_RE_COMP
 	int spattern = (int) pattern;
 #endif
@@ -315,12 +536,13 @@ match_pattern(pattern, tpattern, line, line_len, sp, ep, notbol, search_type)
 	struct regexp *spattern = (struct regexp *) pattern;
 #endif
 
+	stat_match_calls++;
 	*sp = *ep = NULL;
 #if NO_REGEX
 	search_type |= SRCH_NO_REGEX;
 #endif
 	if (search_type & SRCH_NO_REGEX)
-		matched = match(tpattern, strlen(tpattern), line, line_len, sp, ep);
+		matched = match(tpattern, strlen(tpattern), line, line_len, sp, ep, 0);
 	else
 	{
 #if HAVE_GNU_REGEX
@@ -371,6 +593,27 @@ match_pattern(pattern, tpattern, line, line_len, sp, ep, notbol, search_type)
 		}
 	}
 #endif
+#if HAVE_PCRE2
+	{
+		int flags = (notbol) ? PCRE2_NOTBOL : 0;
+		PCRE2_SIZE *ovector;
+		if (pcre2_mdata == NULL)
+			pcre2_mdata = pcre2_match_data_create(1, NULL);
+		/*
+		 * A return of 0 means the match data had no room for the
+		 * capturing groups; the whole match is still recorded.
+		 */
+		matched = pcre2_mdata != NULL &&
+			pcre2_match(spattern, (PCRE2_SPTR) line, line_len,
+				0, flags, pcre2_mdata, NULL) >= 0;
+		if (matched)
+		{
+			ovector = pcre2_get_ovector_pointer(pcre2_mdata);
+			*sp = line + ovector[0];
+			*ep = line + ovector[1];
+		}
+	}
+#endif
 #if HAVE_RE_COMP
 	matched = (re_exec(line) == 1);
 	/*
@@ -402,3 +645,195 @@ match_pattern(pattern, tpattern, line, line_len, sp, ep, notbol, search_type)
 	return (matched);
 }
 
+
+/*
+ * An Aho-Corasick automaton, which finds every occurrence of
+ * several literal strings in one pass over a line.
+ * It is built from the strings folded to lowercase, and the
+ * transitions are precomputed, so each byte of the line costs
+ * one table lookup.  A string which is not caseless is checked
+ * against the line as it was before folding.  Unlike match,
+ * this folds only through fold_table, so in UTF-8 mode only
+ * ASCII letters are folded.
+ */
+struct acmatcher
+{
+	int nstates;
+	int (*next)[256];	/* Transition on each byte from each state */
+	int *out;		/* First string ending at each state, or -1 */
+	int *dict;		/* Next state on the failure chain with a string, or -1 */
+	int nwords;
+	char **words;
+	int *wlen;
+	int *wnext;		/* Next string which folds the same, or -1 */
+	int *caseless;
+};
+
+/*
+ * Build an automaton which matches any of a set of strings.
+ * caseless[i] says whether case is ignored when matching words[i].
+ */
+	public void *
+ac_compile(words, nwords, caseless)
+	char **words;
+	int nwords;
+	int *caseless;
+{
+	struct acmatcher *ac;
+	int *fail;
+	int *queue;
+	int maxstates;
+	int qhead, qtail;
+	int i, s, t, c;
+	char *p;
+
+	if (fold_table_mode != utf_mode)
+		init_fold_table();
+	maxstates = 1;
+	for (i = 0;  i < nwords;  i++)
+		maxstates += (int) strlen(words[i]);
+
+	ac = (struct acmatcher *) ecalloc(1, sizeof(struct acmatcher));
+	ac->next = (int (*)[256]) ecalloc(maxstates, sizeof(*ac->next));
+	ac->out = (int *) ecalloc(maxstates, sizeof(int));
+	ac->dict = (int *) ecalloc(maxstates, sizeof(int));
+	ac->nwords = nwords;
+	ac->words = (char **) ecalloc(nwords, sizeof(char *));
+	ac->wlen = (int *) ecalloc(nwords, sizeof(int));
+	ac->wnext = (int *) ecalloc(nwords, sizeof(int));
+	ac->caseless = (int *) ecalloc(nwords, sizeof(int));
+	fail = (int *) ecalloc(maxstates, sizeof(int));
+	queue = (int *) ecalloc(maxstates, sizeof(int));
+
+	/*
+	 * Build the trie of the folded strings.
+	 */
+	for (s = 0;  s < maxstates;  s++)
+	{
+		for (c = 0;  c < 256;  c++)
+			ac->next[s][c] = -1;
+		ac->out[s] = ac->dict[s] = -1;
+	}
+	ac->nstates = 1;
+	for (i = 0;  i < nwords;  i++)
+	{
+		ac->words[i] = save(words[i]);
+		ac->wlen[i] = (int) strlen(words[i]);
+		ac->caseless[i] = caseless[i];
+		ac->wnext[i] = -1;
+		s = 0;
+		for (p = words[i];  *p != '\0';  p++)
+		{
+			c = fold_table[(unsigned char) *p];
+			if (ac->next[s][c] < 0)
+				ac->next[s][c] = ac->nstates++;
+			s = ac->next[s][c];
+		}
+		if (ac->wlen[i] == 0)
+			continue;
+		if (ac->out[s] < 0)
+			ac->out[s] = i;
+		else
+		{
+			for (t = ac->out[s];  ac->wnext[t] >= 0;  t = ac->wnext[t])
+				continue;
+			ac->wnext[t] = i;
+		}
+	}
+
+	/*
+	 * Visit the states breadth first, setting the failure state of
+	 * each and filling in the transitions which are not in the trie.
+	 */
+	qhead = qtail = 0;
+	for (c = 0;  c < 256;  c++)
+	{
+		t = ac->next[0][c];
+		if (t < 0)
+			ac->next[0][c] = 0;
+		else
+		{
+			fail[t] = 0;
+			queue[qtail++] = t;
+		}
+	}
+	while (qhead < qtail)
+	{
+		s = queue[qhead++];
+		for (c = 0;  c < 256;  c++)
+		{
+			t = ac->next[s][c];
+			if (t < 0)
+			{
+				ac->next[s][c] = ac->next[fail[s]][c];
+				continue;
+			}
+			fail[t] = ac->next[fail[s]][c];
+			ac->dict[t] = (ac->out[fail[t]] >= 0) ? fail[t] : ac->dict[fail[t]];
+			queue[qtail++] = t;
+		}
+	}
+	free(fail);
+	free(queue);
+	return ((void *) ac);
+}
+
+/*
+ * Free an automaton made by ac_compile.
+ */
+	public void
+ac_free(acp)
+	void *acp;
+{
+	struct acmatcher *ac = (struct acmatcher *) acp;
+	int i;
+
+	for (i = 0;  i < ac->nwords;  i++)
+		free(ac->words[i]);
+	free(ac->words);
+	free(ac->wlen);
+	free(ac->wnext);
+	free(ac->caseless);
+	free(ac->next);
+	free(ac->out);
+	free(ac->dict);
+	free(ac);
+}
+
+/*
+ * Find every occurrence of the automaton's strings in a line,
+ * including overlapping ones.  For each, call
+ * (*found)(i, sp, ep, arg), where i is the index of the string
+ * and sp and ep delimit where it matched.
+ */
+	public void
+ac_scan(acp, line, line_len, found, arg)
+	void *acp;
+	char *line;
+	int line_len;
+	void (*found)();
+	void *arg;
+{
+	struct acmatcher *ac = (struct acmatcher *) acp;
+	char *line_end = line + line_len;
+	char *p;
+	char *sp;
+	int state = 0;
+	int s, w;
+
+	for (p = line;  p < line_end;  p++)
+	{
+		state = ac->next[state][fold_table[(unsigned char) *p]];
+		for (s = (ac->out[state] >= 0) ? state : ac->dict[state];
+		     s >= 0;  s = ac->dict[s])
+		{
+			for (w = ac->out[s];  w >= 0;  w = ac->wnext[w])
+			{
+				sp = p + 1 - ac->wlen[w];
+				if (ac->caseless[w] ||
+				    strncmp(sp, ac->words[w], ac->wlen[w]) == 0)
+					(*found)(w, sp, p + 1, arg);
+			}
+		}
+	}
+}
@@ -31,6 +31,13 @@
 #define CLEAR_PATTERN(name)   name = NULL
 #endif
 
+#if HAVE_PCRE2
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#define DEFINE_PATTERN(name)  pcre2_code *name
+#define CLEAR_PATTERN(name)   name = NULL
+#endif
+
 #if HAVE_RE_COMP
 char *re_comp();
 int re_exec();
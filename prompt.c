@@ -30,6 +30,7 @@ extern int sc_height;
 extern int jump_sline;
 extern int less_is_more;
 extern IFILE curr_ifile;
+extern int linenum_gen;
 #if EDITOR
 extern char *editor;
 extern char *editproto;
@@ -62,6 +63,42 @@ public char constant *wproto = w_proto;
 static char message[PROMPT_SIZE];
 static char *mp;
 
+/*
+ * A prompt may ask for the same value several times (e.g. "%lt" in
+ * both a conditional and an escape), so the byte offset and line
+ * number of each "where" line are found only once per expansion.
+ */
+#define	NMEMO		8
+#define	PM_POS		01
+#define	PM_LINE		02
+
+static struct pmemo {
+	int where;
+	int flags;
+	POSITION pos;
+	LINENUM linenum;
+} pmemo[NMEMO];
+static int npmemo;
+
+/*
+ * The final line number is also remembered from one prompt to the
+ * next, as long as the file, its length and the line number cache
+ * are unchanged.  A prompt only counts the lines to the end of
+ * the file if a cached line number is within PR_MAXREAD bytes
+ * of the end; otherwise the total is shown as unknown.
+ * The = command has no such limit.
+ */
+#define	PR_MAXREAD	((POSITION)1024*1024)
+
+static int pm_havelast;
+static LINENUM pm_last;
+static int pr_thorough;
+
+static IFILE last_ifile = NULL_IFILE;
+static POSITION last_len = NULL_POSITION;
+static int last_gen;
+static LINENUM last_linenum;
+
 /*
  * Initialize the prompt prototype strings.
  */
@@ -155,6 +192,26 @@ ap_quest()
 	ap_str("?");
 }
 
+/*
+ * Return the memo entry for a "where" line, creating it if necessary.
+ */
+	static struct pmemo *
+get_memo(where)
+	int where;
+{
+	struct pmemo *m;
+
+	for (m = pmemo;  m < &pmemo[npmemo];  m++)
+		if (m->where == where)
+			return (m);
+	if (npmemo < NMEMO)
+		npmemo++;
+	m = &pmemo[npmemo-1];
+	m->where = where;
+	m->flags = 0;
+	return (m);
+}
+
 /*
  * Return the "current" byte offset in the file.
  */
@@ -162,16 +219,71 @@ ap_quest()
 curr_byte(where)
 	int where;
 {
+	struct pmemo *m;
 	POSITION pos;
 
+	m = get_memo(where);
+	if (m->flags & PM_POS)
+		return (m->pos);
 	pos = position(where);
 	while (pos == NULL_POSITION && where >= 0 && where < sc_height-1)
 		pos = position(++where);
 	if (pos == NULL_POSITION)
 		pos = ch_length();
+	m->pos = pos;
+	m->flags |= PM_POS;
 	return (pos);
 }
 
+/*
+ * Return the "current" line number.
+ */
+	static LINENUM
+curr_line(where)
+	int where;
+{
+	struct pmemo *m;
+
+	m = get_memo(where);
+	if (!(m->flags & PM_LINE))
+	{
+		m->linenum = currline(where);
+		m->flags |= PM_LINE;
+	}
+	return (m->linenum);
+}
+
+/*
+ * Return the line number of the end of the file
+ * (one more than the number of lines in the file),
+ * or 0 if it is not known.
+ */
+	static LINENUM
+final_line()
+{
+	POSITION len;
+
+	if (pm_havelast)
+		return (pm_last);
+	pm_havelast = 1;
+	pm_last = 0;
+	len = ch_length();
+	if (!linenums || len == NULL_POSITION || len == ch_zero())
+		return (pm_last);
+	if (curr_ifile == last_ifile && len == last_len &&
+	    linenum_gen == last_gen)
+		return (pm_last = last_linenum);
+	pm_last = find_linenum_within(len, pr_thorough ? -1 : PR_MAXREAD);
+	if (pm_last > 0)
+	{
+		last_ifile = curr_ifile;
+		last_len = len;
+		last_gen = linenum_gen;
+		last_linenum = pm_last;
+	}
+	return (pm_last);
+}
+
 /*
  * Return the value of a prototype conditional.
  * A prototype string may include conditionals which consist of a 
@@ -183,8 +295,6 @@ cond(c, where)
 	char c;
 	int where;
 {
-	POSITION len;
-
 	switch (c)
 	{
 	case 'a':	/* Anything in the message yet? */
@@ -201,8 +311,9 @@ cond(c, where)
 	case 'd':	/* Same as l */
 		return (linenums);
 	case 'L':	/* Final line number known? */
+		return (final_line() > 0);
 	case 'D':	/* Final page number known? */
-		return (linenums && ch_length() != NULL_POSITION);
+		return (ch_length() == ch_zero() ? linenums : final_line() > 0);
 	case 'm':	/* More than one file? */
 #if TAGS
 		return (ntags() ? (ntags() > 1) : (nifile() > 1));
@@ -219,9 +330,7 @@ cond(c, where)
 		return (curr_byte(where) != NULL_POSITION && 
 				ch_length() > 0);
 	case 'P':	/* Percent into file (lines) known? */
-		return (currline(where) != 0 &&
-				(len = ch_length()) > 0 &&
-				find_linenum(len) != 0);
+		return (curr_line(where) != 0 && final_line() > 0);
 	case 's':	/* Size of file known? */
 	case 'B':
 		return (ch_length() != NULL_POSITION);
@@ -252,7 +361,7 @@ protochar(c, where, iseditproto)
 	POSITION len;
 	int n;
 	LINENUM linenum;
-	LINENUM last_linenum;
+	LINENUM last;
 	IFILE h;
 
 #undef  PAGE_NUM
@@ -271,7 +380,7 @@ protochar(c, where, iseditproto)
 		ap_int(hshift);
 		break;
 	case 'd':	/* Current page number */
-		linenum = currline(where);
+		linenum = curr_line(where);
 		if (linenum > 0 && sc_height > 1)
 			ap_linenum(PAGE_NUM(linenum));
 		else
@@ -287,7 +396,13 @@ protochar(c, where, iseditproto)
 			ap_linenum(0);
 		else
 		{
-			linenum = find_linenum(len - 1);
+			/*
+			 * Once final_line has found the end of the file,
+			 * the line number table makes this lookup quick.
+			 */
+			linenum = final_line();
+			if (linenum > 0)
+				linenum = find_linenum(len - 1);
 			if (linenum <= 0)
 				ap_quest();
 			else 
@@ -314,16 +429,14 @@ protochar(c, where, iseditproto)
 			ap_int(get_index(curr_ifile));
 		break;
 	case 'l':	/* Current line number */
-		linenum = currline(where);
+		linenum = curr_line(where);
 		if (linenum != 0)
 			ap_linenum(linenum);
 		else
 			ap_quest();
 		break;
 	case 'L':	/* Final line number */
-		len = ch_length();
-		if (len == NULL_POSITION || len == ch_zero() ||
-		    (linenum = find_linenum(len)) <= 0)
+		if ((linenum = final_line()) <= 0)
 			ap_quest();
 		else
 			ap_linenum(linenum-1);
@@ -346,13 +459,11 @@ protochar(c, where, iseditproto)
 			ap_quest();
 		break;
 	case 'P':	/* Percent into file (lines) */
-		linenum = currline(where);
-		if (linenum == 0 ||
-		    (len = ch_length()) == NULL_POSITION || len == ch_zero() ||
-		    (last_linenum = find_linenum(len)) <= 0)
+		linenum = curr_line(where);
+		if (linenum == 0 || (last = final_line()) <= 0)
 			ap_quest();
 		else
-			ap_int(percentage(linenum, last_linenum));
+			ap_int(percentage(linenum, last));
 		break;
 	case 's':	/* Size of file */
 	case 'B':
@@ -484,6 +595,8 @@ pr_expand(proto, maxwidth)
 	int where;
 
 	mp = message;
+	npmemo = 0;
+	pm_havelast = 0;
 
 	if (*proto == '\0')
 		return ("");
@@ -553,7 +666,12 @@ pr_expand(proto, maxwidth)
 	public char *
 eq_message()
 {
-	return (pr_expand(eqproto, 0));
+	char *msg;
+
+	pr_thorough = 1;
+	msg = pr_expand(eqproto, 0);
+	pr_thorough = 0;
+	return (msg);
 }
 
 /*
@@ -25,6 +25,11 @@
  * *** NOTE: this code has been altered slightly for use in Tcl. ***
  * Slightly modified by David MacKenzie to undo most of the changes for TCL.
  * Added regexec2 with notbol parameter. -- 4/19/99 Mark Nudelman
+ * Added a lazily built DFA which regexec2 uses to reject strings which
+ * cannot match, and to limit where the backtracking matcher is started,
+ * and regrelease to free a regexp along with its DFA.
+ * Bounded the backtracking matcher; a string which it gives up on is
+ * matched by simulating the program as an NFA instead.
  */
 
 #include "less.h"
@@ -48,6 +53,8 @@
  * reganch	is the match anchored (at beginning-of-line only)?
  * regmust	string (pointer into program) that match must include, or NULL
  * regmlen	length of regmust string
+ * regdfa	DFA built from the program by regexec2, or NULL
+ * regnodfa	the program is too big to be run as a DFA
  *
  * Regstart and reganch permit very fast decisions on suitable starting points
  * for a match, cutting down the work a lot.  Regmust permits fast rejection
@@ -253,6 +260,8 @@ char *exp;
 	r->reganch = 0;
 	r->regmust = NULL;
 	r->regmlen = 0;
+	r->regdfa = NULL;
+	r->regnodfa = 0;
 	scan = r->program+1;			/* First BRANCH. */
 	if (OP(regnext(scan)) == END) {		/* Only one top-level choice. */
 		scan = OPERAND(scan);
@@ -705,6 +714,17 @@ static char *reginput;		/* String-input pointer. */
 static char *regbol;		/* Beginning of input, for ^ check. */
 static char **regstartp;	/* Pointer to startp array. */
 static char **regendp;		/* Ditto for endp. */
+static long regsteps;		/* Steps left before backtracking gives up. */
+
+/*
+ * Backtracking can take time exponential in the length of the string.
+ * It is allowed this many steps per char of the string (plus a few
+ * for short strings); after that, the string is matched by regpike,
+ * which takes time proportional to the length of the string times
+ * the size of the program.
+ */
+#define	REGSTEPS_BASE		1024
+#define	REGSTEPS_PER_CHAR	64
 
 /*
  * Forwards.
@@ -712,6 +732,10 @@ static char **regendp;		/* Ditto for endp. */
 STATIC int regtry();
 STATIC int regmatch();
 STATIC int regrepeat();
+STATIC struct regdfa *regdfanew();
+STATIC void regdfafree();
+STATIC char *regdfaexec();
+STATIC int regpike();
 
 #ifdef DEBUG
 int regnarrate = 0;
@@ -729,6 +753,7 @@ register char *string;
 int notbol;
 {
 	register char *s;
+	register char *limit;
 
 	/* Be paranoid... */
 	if (prog == NULL || string == NULL) {
@@ -754,23 +779,50 @@ int notbol;
 			return(0);
 	}
 
+	/*
+	 * Run the DFA, if the program is small enough to have one.
+	 * It finds the earliest point at which any match ends;
+	 * the leftmost match must start at or before that point.
+	 */
+	limit = NULL;
+	if (prog->regdfa == NULL && !prog->regnodfa) {
+		prog->regdfa = regdfanew(prog);
+		if (prog->regdfa == NULL)
+			prog->regnodfa = 1;
+	}
+	if (prog->regdfa != NULL) {
+		limit = regdfaexec(prog->regdfa, string, notbol);
+		if (limit == NULL)
+			return(0);
+	}
+
 	/* Mark beginning of line for ^ . */
 	if (notbol)
 		regbol = NULL;
 	else
 		regbol = string;
 
+	regsteps = REGSTEPS_BASE + REGSTEPS_PER_CHAR * (long) strlen(string);
+
 	/* Simplest case:  anchored match need be tried only once. */
-	if (prog->reganch)
-		return(regtry(prog, string));
+	if (prog->reganch) {
+		if (regtry(prog, string))
+			return(1);
+		if (regsteps < 0)
+			return(regpike(prog, string, limit));
+		return(0);
+	}
 
 	/* Messy cases:  unanchored match. */
 	s = string;
 	if (prog->regstart != '\0')
 		/* We know what char it must start with. */
-		while ((s = strchr(s, prog->regstart)) != NULL) {
+		while ((s = strchr(s, prog->regstart)) != NULL &&
+		    (limit == NULL || s <= limit)) {
 			if (regtry(prog, s))
 				return(1);
+			if (regsteps < 0)
+				return(regpike(prog, string, limit));
 			s++;
 		}
 	else
@@ -778,7 +830,9 @@ int notbol;
 		do {
 			if (regtry(prog, s))
 				return(1);
-		} while (*s++ != '\0');
+			if (regsteps < 0)
+				return(regpike(prog, string, limit));
+		} while (*s++ != '\0' && (limit == NULL || s <= limit));
 
 	/* Failure. */
 	return(0);
@@ -792,6 +846,20 @@ register char *string;
 	return regexec2(prog, string, 0);
 }
 
+/*
+ - regrelease - free a regexp made by regcomp
+ */
+void
+regrelease(prog)
+regexp *prog;
+{
+	if (prog == NULL)
+		return;
+	if (prog->regdfa != NULL)
+		regdfafree(prog->regdfa);
+	free(prog);
+}
+
 /*
  - regtry - try match at specific point
  */
@@ -849,6 +917,9 @@ char *prog;
 		if (regnarrate)
 			fprintf(stderr, "%s...\n", regprop(scan));
 #endif
+		/* Give up if this is taking too long. */
+		if (--regsteps < 0)
+			return(0);
 		next = regnext(scan);
 
 		switch (OP(scan)) {
@@ -961,6 +1032,8 @@ char *prog;
 						save = reginput;
 						if (regmatch(OPERAND(scan)))
 							return(1);
+						if (regsteps < 0)
+							return(0);
 						reginput = save;
 						scan = regnext(scan);
 					} while (scan != NULL && OP(scan) == BRANCH);
@@ -992,6 +1065,8 @@ char *prog;
 					if (nextch == '\0' || *reginput == nextch)
 						if (regmatch(next))
 							return(1);
+					if (regsteps < 0)
+						return(0);
 					/* Couldn't or didn't -- back up. */
 					no--;
 					reginput = save + no;
@@ -1090,6 +1165,743 @@ register char *p;
 		return(p+offset);
 }
 
+/*
+ * The DFA.
+ *
+ * The program is also an NFA whose states ("items") are the points at
+ * which it consumes a character: each ANY, ANYOF and ANYBUT node, each
+ * character of an EXACTLY node, each STAR node, two for each PLUS node
+ * (before and after its first repetition), plus EOL and END nodes,
+ * which wait for the end of the string and report a match.  The other
+ * nodes match the empty string and are followed through when the set
+ * of items reachable from a point in the program is found.
+ *
+ * A DFA state is a set of items.  States are built only when they are
+ * first reached, and are kept, along with their transitions, from one
+ * call of regexec2 to the next.  A new item set is started at every
+ * character, so the DFA looks for a match starting anywhere in the
+ * string.  Characters which no node of the program tells apart share
+ * a "class" and a transition.  If too many states are built, they are
+ * all thrown away and building starts again.
+ *
+ * There is no pathological case: each character of the string costs
+ * one table lookup once its state and transition have been built, and
+ * building a transition costs time proportional to the program size.
+ */
+#define	DFA_MAXITEMS	1024	/* Bigger programs don't get a DFA. */
+#define	DFA_MAXSTATES	256	/* States kept before starting again. */
+#define	DFA_HASHSIZE	256
+
+#define	WBITS		(8 * (int) sizeof(unsigned int))
+#define	SETITEM(set,i)	((set)[(i)/WBITS] |= 1U << ((i)%WBITS))
+#define	ISITEM(set,i)	((set)[(i)/WBITS] & (1U << ((i)%WBITS)))
+
+struct dfastate {
+	struct dfastate *hnext;		/* Next state in hash chain. */
+	struct dfastate **next;		/* Transition on each char class. */
+	unsigned int *set;		/* Items in this state. */
+	char bol;			/* At the beginning of the line. */
+	char accept;			/* A match ends here. */
+	char eolaccept;			/* A match ends here if the string does. */
+	char dead;			/* No match is possible from here. */
+};
+
+struct regdfa {
+	regexp *prog;
+	int nitems;			/* Number of items. */
+	int nwords;			/* Words in an item set. */
+	int nclass;			/* Number of char classes. */
+	int enditem;			/* The item of the END node. */
+	unsigned char cls[256];		/* Class of each char. */
+	short *itemof;			/* Program offset -> first item. */
+	char **itemnode;		/* Item -> its node. */
+	short *itemoff;			/* Item -> index within its node. */
+	int *mark;			/* Program offset -> last visit. */
+	int stamp;			/* Current visit. */
+	int ateol;			/* Following EOL nodes through. */
+	unsigned int *tmp;		/* Set being built. */
+	unsigned int *eoltmp;		/* Set built to check for eolaccept. */
+	struct dfastate *hash[DFA_HASHSIZE];
+	struct dfastate *start[2];	/* Initial states: notbol, bol. */
+	int nstates;
+	int nflush;			/* Times the states were thrown away. */
+};
+
+/*
+ - regnodelen - length of a node, including its literal string operand
+ */
+static int
+regnodelen(p)
+char *p;
+{
+	if (OP(p) == ANYOF || OP(p) == ANYBUT || OP(p) == EXACTLY)
+		return(3 + (int) strlen(OPERAND(p)) + 1);
+	return(3);
+}
+
+/*
+ - regdfasplit - split the char classes by whether chars are in a set
+ */
+static void
+regdfasplit(d, in)
+register struct regdfa *d;
+char *in;
+{
+	short map[512];
+	register int c;
+	register int k;
+
+	for (k = 0; k < 512; k++)
+		map[k] = -1;
+	d->nclass = 0;
+	for (c = 0; c < 256; c++) {
+		k = d->cls[c] * 2 + (in[c] != 0);
+		if (map[k] < 0)
+			map[k] = d->nclass++;
+		d->cls[c] = map[k];
+	}
+}
+
+/*
+ - regdfanew - make an (empty) DFA for a program, or NULL if it can't
+ */
+static struct regdfa *
+regdfanew(prog)
+regexp *prog;
+{
+	register struct regdfa *d;
+	register char *scan;
+	register char *p;
+	register int i;
+	int proglen;
+	int nitems;
+	char in[256];
+
+	/* Count the items. */
+	nitems = 0;
+	for (scan = prog->program + 1; ; scan += regnodelen(scan)) {
+		switch (OP(scan)) {
+		case ANY:
+		case ANYOF:
+		case ANYBUT:
+		case STAR:
+		case EOL:
+		case END:
+			nitems++;
+			break;
+		case PLUS:
+			nitems += 2;
+			break;
+		case EXACTLY:
+			nitems += (int) strlen(OPERAND(scan));
+			break;
+		}
+		if (OP(scan) == END)
+			break;
+	}
+	if (nitems > DFA_MAXITEMS)
+		return(NULL);
+	proglen = (int) (scan - prog->program) + 3;
+
+	d = (struct regdfa *) calloc(1, sizeof(struct regdfa));
+	if (d == NULL)
+		return(NULL);
+	d->prog = prog;
+	d->nitems = nitems;
+	d->nwords = (nitems + WBITS - 1) / WBITS;
+	d->itemof = (short *) malloc(proglen * sizeof(short));
+	d->itemnode = (char **) malloc(nitems * sizeof(char *));
+	d->itemoff = (short *) malloc(nitems * sizeof(short));
+	d->mark = (int *) calloc(proglen, sizeof(int));
+	d->tmp = (unsigned int *) malloc(d->nwords * sizeof(unsigned int));
+	d->eoltmp = (unsigned int *) malloc(d->nwords * sizeof(unsigned int));
+	if (d->itemof == NULL || d->itemnode == NULL || d->itemoff == NULL ||
+	    d->mark == NULL || d->tmp == NULL || d->eoltmp == NULL) {
+		regdfafree(d);
+		return(NULL);
+	}
+
+	/*
+	 * Number the items, and split the chars into classes
+	 * which every node treats alike.
+	 */
+	nitems = 0;
+	for (scan = prog->program + 1; ; scan += regnodelen(scan)) {
+		d->itemof[scan - prog->program] = nitems;
+		switch (OP(scan)) {
+		case ANY:
+		case STAR:
+		case EOL:
+			d->itemnode[nitems] = scan;
+			d->itemoff[nitems++] = 0;
+			break;
+		case END:
+			d->enditem = nitems;
+			d->itemnode[nitems] = scan;
+			d->itemoff[nitems++] = 0;
+			break;
+		case PLUS:
+			for (i = 0; i < 2; i++) {
+				d->itemnode[nitems] = scan;
+				d->itemoff[nitems++] = i;
+			}
+			break;
+		case ANYOF:
+		case ANYBUT:
+			d->itemnode[nitems] = scan;
+			d->itemoff[nitems++] = 0;
+			memset(in, 0, sizeof(in));
+			for (p = OPERAND(scan); *p != '\0'; p++)
+				in[UCHARAT(p)] = 1;
+			regdfasplit(d, in);
+			break;
+		case EXACTLY:
+			for (i = 0, p = OPERAND(scan); *p != '\0'; i++, p++) {
+				d->itemnode[nitems] = scan;
+				d->itemoff[nitems++] = i;
+				memset(in, 0, sizeof(in));
+				in[UCHARAT(p)] = 1;
+				regdfasplit(d, in);
+			}
+			break;
+		}
+		if (OP(scan) == END)
+			break;
+	}
+	if (d->nclass == 0)
+		d->nclass = 1;
+	return(d);
+}
+
+/*
+ - regdfaflush - throw away all the states of a DFA
+ */
+static void
+regdfaflush(d)
+register struct regdfa *d;
+{
+	register struct dfastate *s;
+	register int h;
+
+	for (h = 0; h < DFA_HASHSIZE; h++) {
+		while ((s = d->hash[h]) != NULL) {
+			d->hash[h] = s->hnext;
+			free(s);
+		}
+	}
+	d->start[0] = d->start[1] = NULL;
+	d->nstates = 0;
+	d->nflush++;
+}
+
+/*
+ - regdfafree - free a DFA
+ */
+static void
+regdfafree(d)
+struct regdfa *d;
+{
+	regdfaflush(d);
+	if (d->itemof != NULL)
+		free(d->itemof);
+	if (d->itemnode != NULL)
+		free(d->itemnode);
+	if (d->itemoff != NULL)
+		free(d->itemoff);
+	if (d->mark != NULL)
+		free(d->mark);
+	if (d->tmp != NULL)
+		free(d->tmp);
+	if (d->eoltmp != NULL)
+		free(d->eoltmp);
+	free(d);
+}
+
+/*
+ - regdfaadd - add the items reachable from a node without consuming a char
+ */
+static void
+regdfaadd(d, set, scan, bol)
+register struct regdfa *d;
+unsigned int *set;
+register char *scan;
+int bol;
+{
+	register char *next;
+	register int off;
+
+	while (scan != NULL) {
+		off = (int) (scan - d->prog->program);
+		if (d->mark[off] == d->stamp)
+			return;
+		d->mark[off] = d->stamp;
+		switch (OP(scan)) {
+		case BOL:
+			if (!bol)
+				return;
+			break;
+		case EOL:
+			if (d->ateol)
+				break;
+			SETITEM(set, d->itemof[off]);
+			return;
+		case ANY:
+		case ANYOF:
+		case ANYBUT:
+		case EXACTLY:
+		case PLUS:
+		case END:
+			SETITEM(set, d->itemof[off]);
+			return;
+		case STAR:
+			SETITEM(set, d->itemof[off]);
+			break;
+		case BRANCH:
+			next = regnext(scan);
+			if (OP(next) != BRANCH) {	/* No choice. */
+				scan = OPERAND(scan);
+				continue;
+			}
+			for (; scan != NULL && OP(scan) == BRANCH;
+			    scan = regnext(scan))
+				regdfaadd(d, set, OPERAND(scan), bol);
+			return;
+		default:	/* BACK, NOTHING, OPEN, CLOSE */
+			break;
+		}
+		scan = regnext(scan);
+	}
+}
+
+/*
+ - regdfasimple - does a simple STAR or PLUS operand match a char?
+ */
+static int
+regdfasimple(p, c)
+char *p;
+int c;
+{
+	switch (OP(p)) {
+	case ANY:
+		return(1);
+	case EXACTLY:
+		return(UCHARAT(OPERAND(p)) == c);
+	case ANYOF:
+		return(strchr(OPERAND(p), c) != NULL);
+	case ANYBUT:
+		return(strchr(OPERAND(p), c) == NULL);
+	}
+	return(0);
+}
+
+/*
+ - regdfastate - find or make the state for an item set
+ */
+static struct dfastate *
+regdfastate(d, set, bol)
+register struct regdfa *d;
+unsigned int *set;
+int bol;
+{
+	register struct dfastate *s;
+	register unsigned int h;
+	register int i;
+	int size;
+
+	h = bol;
+	for (i = 0; i < d->nwords; i++)
+		h = h * 31 + set[i];
+	h %= DFA_HASHSIZE;
+	for (s = d->hash[h]; s != NULL; s = s->hnext)
+		if (s->bol == bol &&
+		    memcmp(s->set, set, d->nwords * sizeof(unsigned int)) == 0)
+			return(s);
+
+	if (d->nstates >= DFA_MAXSTATES)
+		regdfaflush(d);
+	size = sizeof(struct dfastate) +
+		d->nclass * sizeof(struct dfastate *) +
+		d->nwords * sizeof(unsigned int);
+	s = (struct dfastate *) calloc(1, size);
+	if (s == NULL)
+		return(NULL);
+	s->next = (struct dfastate **) (s + 1);
+	s->set = (unsigned int *) (s->next + d->nclass);
+	memcpy(s->set, set, d->nwords * sizeof(unsigned int));
+	s->bol = bol;
+	s->accept = ISITEM(set, d->enditem) ? 1 : 0;
+	s->dead = 1;
+	for (i = 0; i < d->nwords; i++)
+		if (set[i] != 0)
+			s->dead = 0;
+
+	/*
+	 * See whether the items waiting at EOL nodes
+	 * can reach END if the string ends here.
+	 */
+	for (i = 0; i < d->nitems && !s->eolaccept; i++) {
+		if (!ISITEM(set, i) || OP(d->itemnode[i]) != EOL)
+			continue;
+		memset(d->eoltmp, 0, d->nwords * sizeof(unsigned int));
+		d->stamp++;
+		d->ateol = 1;
+		regdfaadd(d, d->eoltmp, d->itemnode[i], bol);
+		d->ateol = 0;
+		if (ISITEM(d->eoltmp, d->enditem))
+			s->eolaccept = 1;
+	}
+
+	s->hnext = d->hash[h];
+	d->hash[h] = s;
+	d->nstates++;
+	return(s);
+}
+
+/*
+ - regdfastep - find the state reached from a state on a char
+ */
+static struct dfastate *
+regdfastep(d, s, c)
+register struct regdfa *d;
+struct dfastate *s;
+int c;
+{
+	register unsigned int *set = d->tmp;
+	register char *scan;
+	register char *opnd;
+	register int i;
+
+	memset(set, 0, d->nwords * sizeof(unsigned int));
+	d->stamp++;
+	for (i = 0; i < d->nitems; i++) {
+		if (!ISITEM(s->set, i))
+			continue;
+		scan = d->itemnode[i];
+		switch (OP(scan)) {
+		case ANY:
+			regdfaadd(d, set, regnext(scan), 0);
+			break;
+		case ANYOF:
+			if (strchr(OPERAND(scan), c) != NULL)
+				regdfaadd(d, set, regnext(scan), 0);
+			break;
+		case ANYBUT:
+			if (strchr(OPERAND(scan), c) == NULL)
+				regdfaadd(d, set, regnext(scan), 0);
+			break;
+		case EXACTLY:
+			opnd = OPERAND(scan) + d->itemoff[i];
+			if (UCHARAT(opnd) != c)
+				break;
+			if (opnd[1] != '\0')
+				SETITEM(set, i+1);
+			else
+				regdfaadd(d, set, regnext(scan), 0);
+			break;
+		case STAR:
+		case PLUS:
+			if (!regdfasimple(OPERAND(scan), c))
+				break;
+			/* Go round again, or go on. */
+			SETITEM(set, d->itemof[scan - d->prog->program] +
+				(OP(scan) == PLUS));
+			regdfaadd(d, set, regnext(scan), 0);
+			break;
+		}
+	}
+	/* A match may also start at the next char. */
+	regdfaadd(d, set, d->prog->program + 1, 0);
+	return(regdfastate(d, set, 0));
+}
+
+/*
+ - regdfaexec - run the DFA on a string
+ *
+ * Return where the earliest-ending match ends, or NULL if there is none.
+ * If the DFA runs out of memory, give up and return the end of the string.
+ */
+static char *
+regdfaexec(d, string, notbol)
+register struct regdfa *d;
+char *string;
+int notbol;
+{
+	register struct dfastate *s;
+	register struct dfastate *next;
+	register char *p;
+	register int c;
+	int bol;
+	int nflush;
+
+	bol = !notbol;
+	s = d->start[bol];
+	if (s == NULL) {
+		memset(d->tmp, 0, d->nwords * sizeof(unsigned int));
+		d->stamp++;
+		regdfaadd(d, d->tmp, d->prog->program + 1, bol);
+		s = regdfastate(d, d->tmp, bol);
+		if (s == NULL)
+			return(string + strlen(string));
+		d->start[bol] = s;
+	}
+	for (p = string; ; p++) {
+		if (s->accept)
+			return(p);
+		c = UCHARAT(p);
+		if (c == '\0')
+			return((s->eolaccept) ? p : NULL);
+		if (s->dead)
+			return(NULL);
+		next = s->next[d->cls[c]];
+		if (next == NULL) {
+			nflush = d->nflush;
+			next = regdfastep(d, s, c);
+			if (next == NULL)
+				return(p + strlen(p));
+			/* Don't save it in a state that's been thrown away. */
+			if (d->nflush == nflush)
+				s->next[d->cls[c]] = next;
+		}
+		s = next;
+	}
+}
+
+/*
+ * The NFA simulation.
+ *
+ * When backtracking gives up, the program is run as an NFA over the
+ * string, keeping a list of threads, each at a point where it consumes
+ * a character (the same points as the items of the DFA), along with
+ * where its match started.  The threads of a list are in the order in
+ * which the backtracking matcher would try them, and a thread which
+ * reaches a point already reached by an earlier one in the same list
+ * is dropped, since the earlier one would succeed or fail first.  A
+ * thread which reaches END is the match the backtracking matcher would
+ * have found, unless an earlier thread in its list goes on to another
+ * match, so later threads are dropped and the earlier ones are run on.
+ *
+ * Each thread is identified by its offset in the program: that of its
+ * node, or of the char within an EXACTLY node, or the node plus one
+ * for a PLUS node after its first repetition.  So each character of
+ * the string costs time proportional to the size of the program.
+ * Only startp[0] and endp[0] are set by a match found this way.
+ */
+struct regthread {
+	char *scan;			/* The node. */
+	int off;			/* Char of EXACTLY, or PLUS repeated. */
+	char *start;			/* Where the match started. */
+};
+
+struct regtlist {
+	int n;
+	struct regthread *t;
+};
+
+static char *pikeprog;		/* Program being run. */
+static int *pikemark;		/* Program offset -> last list reached in. */
+static int pikestamp;		/* Current list. */
+
+/*
+ - regpikeput - add a thread to a list
+ */
+static void
+regpikeput(l, scan, off, start)
+struct regtlist *l;
+char *scan;
+int off;
+char *start;
+{
+	register struct regthread *t = &l->t[l->n++];
+
+	t->scan = scan;
+	t->off = off;
+	t->start = start;
+}
+
+/*
+ - regpikeadd - add the threads reachable from a node without consuming a char
+ */
+static void
+regpikeadd(l, scan, start, p)
+struct regtlist *l;
+register char *scan;
+char *start;
+char *p;
+{
+	register char *next;
+	register int off;
+
+	while (scan != NULL) {
+		off = (int) (scan - pikeprog);
+		if (pikemark[off] == pikestamp)
+			return;
+		pikemark[off] = pikestamp;
+		switch (OP(scan)) {
+		case BOL:
+			if (p != regbol)
+				return;
+			break;
+		case EOL:
+			if (*p != '\0')
+				return;
+			break;
+		case ANY:
+		case ANYOF:
+		case ANYBUT:
+		case EXACTLY:
+		case PLUS:
+		case END:
+			regpikeput(l, scan, 0, start);
+			return;
+		case STAR:
+			/* Another repetition is tried before going on. */
+			regpikeput(l, scan, 0, start);
+			break;
+		case BRANCH:
+			next = regnext(scan);
+			if (OP(next) != BRANCH) {	/* No choice. */
+				scan = OPERAND(scan);
+				continue;
+			}
+			for (; scan != NULL && OP(scan) == BRANCH;
+			    scan = regnext(scan))
+				regpikeadd(l, OPERAND(scan), start, p);
+			return;
+		default:	/* BACK, NOTHING, OPEN, CLOSE */
+			break;
+		}
+		scan = regnext(scan);
+	}
+}
+
+/*
+ - regpike - find the match the backtracking matcher would, by running an NFA
+ *
+ * The leftmost match must start at or before limit, if it is not NULL.
+ */
+static int
+regpike(prog, string, limit)
+regexp *prog;
+char *string;
+char *limit;
+{
+	register struct regthread *t;
+	register char *scan;
+	register char *p;
+	register int i;
+	struct regtlist lists[2];
+	struct regtlist *clist;
+	struct regtlist *nlist;
+	struct regtlist *tmp;
+	char *opnd;
+	int proglen;
+	int key;
+	int matched;
+
+	for (scan = prog->program + 1; OP(scan) != END; scan += regnodelen(scan))
+		continue;
+	proglen = (int) (scan - prog->program) + 3;
+	pikeprog = prog->program;
+	pikemark = (int *) calloc(proglen, sizeof(int));
+	lists[0].t = (struct regthread *) malloc(proglen * sizeof(struct regthread));
+	lists[1].t = (struct regthread *) malloc(proglen * sizeof(struct regthread));
+	if (pikemark == NULL || lists[0].t == NULL || lists[1].t == NULL) {
+		if (pikemark != NULL) free(pikemark);
+		if (lists[0].t != NULL) free(lists[0].t);
+		if (lists[1].t != NULL) free(lists[1].t);
+		regerror("out of space");
+		return(0);
+	}
+	for (i = 0; i < NSUBEXP; i++)
+		prog->startp[i] = prog->endp[i] = NULL;
+
+	matched = 0;
+	clist = &lists[0];
+	nlist = &lists[1];
+	clist->n = 0;
+	pikestamp = 1;
+	for (p = string; ; p++) {
+		/*
+		 * A match starting here is tried after all
+		 * those which started earlier.
+		 */
+		if (!matched && (limit == NULL || p <= limit) &&
+		    (!prog->reganch || p == string) &&
+		    (prog->regstart == '\0' || *p == prog->regstart))
+			regpikeadd(clist, prog->program + 1, p, p);
+		if (clist->n == 0 && (matched || *p == '\0' ||
+		    prog->reganch || (limit != NULL && p >= limit)))
+			break;
+
+		pikestamp++;
+		nlist->n = 0;
+		for (i = 0; i < clist->n; i++) {
+			t = &clist->t[i];
+			scan = t->scan;
+			if (OP(scan) == END) {
+				prog->startp[0] = t->start;
+				prog->endp[0] = p;
+				matched = 1;
+				break;
+			}
+			if (*p == '\0')
+				continue;
+			switch (OP(scan)) {
+			case ANY:
+				regpikeadd(nlist, regnext(scan), t->start, p+1);
+				break;
+			case ANYOF:
+				if (strchr(OPERAND(scan), *p) != NULL)
+					regpikeadd(nlist, regnext(scan), t->start, p+1);
+				break;
+			case ANYBUT:
+				if (strchr(OPERAND(scan), *p) == NULL)
+					regpikeadd(nlist, regnext(scan), t->start, p+1);
+				break;
+			case EXACTLY:
+				opnd = OPERAND(scan) + t->off;
+				if (*opnd != *p)
+					break;
+				if (opnd[1] == '\0') {
+					regpikeadd(nlist, regnext(scan), t->start, p+1);
+					break;
+				}
+				key = (int) (opnd + 1 - pikeprog);
+				if (pikemark[key] == pikestamp)
+					break;
+				pikemark[key] = pikestamp;
+				regpikeput(nlist, scan, t->off + 1, t->start);
+				break;
+			case STAR:
+				if (regdfasimple(OPERAND(scan), UCHARAT(p)))
+					regpikeadd(nlist, scan, t->start, p+1);
+				break;
+			case PLUS:
+				if (!regdfasimple(OPERAND(scan), UCHARAT(p)))
+					break;
+				/* Go round again, or go on. */
+				key = (int) (scan + 1 - pikeprog);
+				if (pikemark[key] == pikestamp)
+					break;
+				pikemark[key] = pikestamp;
+				regpikeput(nlist, scan, 1, t->start);
+				regpikeadd(nlist, regnext(scan), t->start, p+1);
+				break;
+			}
+		}
+		if (*p == '\0')
+			break;
+		tmp = clist;
+		clist = nlist;
+		nlist = tmp;
+	}
+
+	free(pikemark);
+	free(lists[0].t);
+	free(lists[1].t);
+	return(matched);
+}
+
 #ifdef DEBUG
 
 STATIC char *regprop();
@@ -16,6 +16,8 @@ typedef struct regexp {
 	char reganch;		/* Internal use only. */
 	char *regmust;		/* Internal use only. */
 	int regmlen;		/* Internal use only. */
+	struct regdfa *regdfa;	/* Internal use only. */
+	char regnodfa;		/* Internal use only. */
 	char program[1];	/* Unwarranted chumminess with compiler. */
 } regexp;
 
@@ -30,5 +32,6 @@ extern int regexec _ANSI_ARGS_((regexp *prog, char *string));
 extern int regexec2 _ANSI_ARGS_((regexp *prog, char *string, int notbol));
 extern void regsub _ANSI_ARGS_((regexp *prog, char *source, char *dest));
 extern void regerror _ANSI_ARGS_((char *msg));
+extern void regrelease _ANSI_ARGS_((regexp *prog));
 
 #endif /* REGEXP */
@@ -162,6 +162,7 @@ static char
 	*sc_pad,		/* Pad string */
 	*sc_home,		/* Cursor home */
 	*sc_addline,		/* Add line, scroll down following lines */
+	*sc_addlines,		/* Add n lines, scroll down following lines */
 	*sc_lower_left,		/* Cursor to last line, first column */
 	*sc_return,		/* Cursor to beginning of current line */
 	*sc_move,		/* General cursor positioning */
@@ -208,6 +209,12 @@ extern int binattr;
 #if !MSDOS_COMPILER
 static char *cheaper();
 static void tmodes();
+static int exit_resets();
+static int cost();
+static int addline_cost;	/* Cost of sc_addline */
+static int at_resets;		/* Modes whose exit turns off other modes too */
+static int at_me;		/* Modes whose exit is "me" */
+static char *sc_me;		/* Exit all modes */
 #endif
 
 /*
@@ -1256,6 +1263,24 @@ get_term()
 	tmodes("md", "me", &sc_b_in, &sc_b_out, sc_s_in, sc_s_out, &sp);
 	tmodes("mb", "me", &sc_bl_in, &sc_bl_out, sc_s_in, sc_s_out, &sp);
 
+	/*
+	 * Note which modes can't be turned off without turning
+	 * off other modes as well: those which exit with "me",
+	 * or which share an exit string with another mode.
+	 */
+	sc_me = ltgetstr("me", &sp);
+	if (sc_me == NULL)
+		sc_me = "";
+	at_resets = at_me = 0;
+	if (exit_resets(sc_s_out, AT_STANDOUT))
+		at_resets |= AT_STANDOUT;
+	if (exit_resets(sc_u_out, AT_UNDERLINE))
+		at_resets |= AT_UNDERLINE;
+	if (exit_resets(sc_b_out, AT_BOLD))
+		at_resets |= AT_BOLD;
+	if (exit_resets(sc_bl_out, AT_BLINK))
+		at_resets |= AT_BLINK;
+
 	sc_visual_bell = ltgetstr("vb", &sp);
 	if (sc_visual_bell == NULL)
 		sc_visual_bell = "";
@@ -1336,6 +1361,27 @@ get_term()
 		 */
 		no_back_scroll = 1;
 	}
+	addline_cost = cost(sc_addline);
+
+	/*
+	 * Likewise choose between "AL" and "SR", which add
+	 * several lines at once.  These take a count, so we
+	 * compare their cost at a typical count.
+	 * add_lines() decides whether to use them at all.
+	 */
+	t1 = ltgetstr("AL", &sp);
+	if (t1 == NULL)
+		t1 = "";
+	t2 = ltgetstr("SR", &sp);
+	if (t2 == NULL || above_mem)
+		t2 = "";
+	if (*t1 == '\0' || *t2 == '\0')
+		sc_addlines = (*t1 == '\0') ? t2 : t1;
+	else
+	{
+		strcpy(sp, tgoto(t1, 0, sc_height/2));
+		sc_addlines = (cost(sp) <= cost(tgoto(t2, 0, sc_height/2))) ? t1 : t2;
+	}
 #endif /* MSDOS_COMPILER */
 }
 
@@ -1419,6 +1465,30 @@ tmodes(incap, outcap, instr, outstr, def_instr, def_outstr, spp)
 		*outstr = "";
 }
 
+/*
+ * Does an attribute exit string also turn off other attributes?
+ */
+	static int
+exit_resets(outstr, attr)
+	char *outstr;
+	int attr;
+{
+	int n = 0;
+
+	if (*outstr == '\0')
+		return (0);
+	if (strcmp(outstr, sc_me) == 0)
+	{
+		at_me |= attr;
+		return (1);
+	}
+	if (strcmp(outstr, sc_s_out) == 0) n++;
+	if (strcmp(outstr, sc_u_out) == 0) n++;
+	if (strcmp(outstr, sc_b_out) == 0) n++;
+	if (strcmp(outstr, sc_bl_out) == 0) n++;
+	return (n > 1);
+}
+
 #endif /* MSDOS_COMPILER */
 
 
@@ -1664,6 +1734,35 @@ add_line()
 #endif
 }
 
+/*
+ * Add n blank lines (called with cursor at home).
+ * Should scroll the display down n lines.
+ */
+	public void
+add_lines(n)
+	int n;
+{
+#if !MSDOS_COMPILER
+	char *s;
+
+	if (n > 1 && *sc_addlines != '\0')
+	{
+		/*
+		 * Use the parameterized string if it is
+		 * cheaper than sending "al" or "sr" n times.
+		 */
+		s = tgoto(sc_addlines, 0, n);
+		if (cost(s) < n * addline_cost)
+		{
+			tputs(s, sc_height, putchr);
+			return;
+		}
+	}
+#endif
+	while (--n >= 0)
+		add_line();
+}
+
 #if 0
 /*
  * Remove the n topmost lines and scroll everything below it in the 
@@ -2188,13 +2287,14 @@ clear_bot()
 	}
 }
 
-	public void
-at_enter(attr)
+#if !MSDOS_COMPILER
+/*
+ * Send the strings which enter the given attribute modes.
+ */
+	static void
+at_in(attr)
 	int attr;
 {
-	attr = apply_at_specials(attr);
-
-#if !MSDOS_COMPILER
 	/* The one with the most priority is last.  */
 	if (attr & AT_UNDERLINE)
 		tputs(sc_u_in, 1, putchr);
@@ -2204,6 +2304,44 @@ at_enter(attr)
 		tputs(sc_bl_in, 1, putchr);
 	if (attr & AT_STANDOUT)
 		tputs(sc_s_in, 1, putchr);
+}
+
+/*
+ * Send the strings which exit the given attribute modes.
+ * Don't send the same string twice in a row.
+ */
+	static void
+at_out(attr)
+	int attr;
+{
+	char *last = NULL;
+
+	if (attr & at_me)
+	{
+		/* "me" turns off everything at once. */
+		tputs(sc_me, 1, putchr);
+		return;
+	}
+	/* Undo things in the reverse order we did them.  */
+	if (attr & AT_STANDOUT)
+		tputs(last = sc_s_out, 1, putchr);
+	if ((attr & AT_BLINK) && (last == NULL || strcmp(last, sc_bl_out) != 0))
+		tputs(last = sc_bl_out, 1, putchr);
+	if ((attr & AT_BOLD) && (last == NULL || strcmp(last, sc_b_out) != 0))
+		tputs(last = sc_b_out, 1, putchr);
+	if ((attr & AT_UNDERLINE) && (last == NULL || strcmp(last, sc_u_out) != 0))
+		tputs(sc_u_out, 1, putchr);
+}
+#endif
+
+	public void
+at_enter(attr)
+	int attr;
+{
+	attr = apply_at_specials(attr);
+
+#if !MSDOS_COMPILER
+	at_in(attr);
 #else
 	flush();
 	/* The one with the most priority is first.  */
@@ -2231,15 +2369,7 @@ at_enter(attr)
 at_exit()
 {
 #if !MSDOS_COMPILER
-	/* Undo things in the reverse order we did them.  */
-	if (attrmode & AT_STANDOUT)
-		tputs(sc_s_out, 1, putchr);
-	if (attrmode & AT_BLINK)
-		tputs(sc_bl_out, 1, putchr);
-	if (attrmode & AT_BOLD)
-		tputs(sc_b_out, 1, putchr);
-	if (attrmode & AT_UNDERLINE)
-		tputs(sc_u_out, 1, putchr);
+	at_out(attrmode);
 #else
 	flush();
 	SETCOLORS(nm_fg_color, nm_bg_color);
@@ -2254,12 +2384,29 @@ at_switch(attr)
 {
 	int new_attrmode = apply_at_specials(attr);
 	int ignore_modes = AT_ANSI;
+#if !MSDOS_COMPILER
+	int gone;
+#endif
 
-	if ((new_attrmode & ~ignore_modes) != (attrmode & ~ignore_modes))
+	if ((new_attrmode & ~ignore_modes) == (attrmode & ~ignore_modes))
+		return;
+#if !MSDOS_COMPILER
+	/*
+	 * Only turn off the modes we are leaving and turn on
+	 * the ones we are entering, unless turning off a mode
+	 * would turn off others too.
+	 */
+	gone = attrmode & ~new_attrmode & ~ignore_modes;
+	if ((gone & at_resets) == 0)
 	{
-		at_exit();
-		at_enter(attr);
+		at_out(gone);
+		at_in(new_attrmode & ~attrmode);
+		attrmode = new_attrmode;
+		return;
 	}
+#endif
+	at_exit();
+	at_enter(attr);
 }
 
 	public int
@@ -2484,6 +2631,29 @@ WIN32getch(tty)
 }
 #endif
 
+/*
+ * Has a key been typed which has not been read yet?
+ */
+	public int
+tty_pending()
+{
+#if MSDOS_COMPILER==WIN32C
+	return (pending_scancode || win32_kbhit((HANDLE)tty));
+#else
+#if MSDOS_COMPILER
+	return (kbhit());
+#else
+#ifdef FIONREAD
+	int n;
+
+	if (ioctl(tty, FIONREAD, &n) == 0 && n > 0)
+		return (1);
+#endif
+	return (0);
+#endif
+#endif
+}
+
 #if MSDOS_COMPILER
 /*
  */
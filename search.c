@@ -16,10 +16,19 @@
 #include "pattern.h"
 #include "position.h"
 #include "charset.h"
+#if HAVE_STAT
+#include <sys/stat.h>
+#ifndef S_ISREG
+#define	S_ISREG(m)	(((m) & S_IFMT) == S_IFREG)
+#endif
+#endif
 
 #define	MINPOS(a,b)	(((a) < (b)) ? (a) : (b))
 #define	MAXPOS(a,b)	(((a) > (b)) ? (a) : (b))
 
+public long stat_search_lines;	/* Number of lines examined by search_range */
+public double stat_search_time;	/* Time spent in search_range */
+
 extern int sigs;
 extern int how_search;
 extern int caseless;
@@ -34,6 +43,13 @@ extern POSITION start_attnpos;
 extern POSITION end_attnpos;
 extern int utf_mode;
 extern int screen_trashed;
+extern char *statsfile;
+extern int use_lessopen;
+extern int secure;
+extern int same_pos_bell;
+#if HAVE_ZLIB
+extern int decompress;
+#endif
 #if HILITE_SEARCH
 extern int hilite_search;
 extern int size_linebuf;
@@ -44,57 +60,51 @@ static POSITION prep_startpos;
 static POSITION prep_endpos;
 static int is_caseless;
 static int is_ucase_pattern;
+static int hilite_gen;		/* Changed when saved hilites become invalid */
 
 /*
  * Structures for maintaining a set of ranges for hilites and filtered-out
- * lines. Each range is stored as a node within a red-black tree, and we
- * try to extend existing ranges (without creating overlaps) rather than
- * create new nodes if possible. We remember the last node found by a
- * search for constant-time lookup if the next search is near enough to
- * the previous. To aid that, we overlay a secondary doubly-linked list
- * on top of the red-black tree so we can find the preceding/succeeding
- * nodes also in constant time.
+ * lines.  The ranges are kept sorted, without overlaps, in fixed-size
+ * blocks of (start, end) pairs, and an array of pointers to the blocks
+ * lets a lookup binary-search the blocks and then the ranges in a block.
+ * We try to extend existing ranges rather than add new ones if possible.
  *
- * Each node is allocated from a series of pools, each pool double the size
- * of the previous (for amortised constant time allocation). Since our only
- * tree operations are clear and node insertion, not node removal, we don't
- * need to maintain a usage bitmap or freelist and can just return nodes
- * from the pool in-order until capacity is reached.
+ * Searches usually add ranges in increasing order, so adding a range
+ * after the last one just appends it to the last block.  A range added
+ * elsewhere is inserted into its block, and a full block is split.
+ * We remember the block found by the last lookup, since the next
+ * lookup is usually near the previous one.
  */
 struct hilite
 {
 	POSITION hl_startpos;
 	POSITION hl_endpos;
 };
-struct hilite_node
-{
-	struct hilite_node *parent;
-	struct hilite_node *left;
-	struct hilite_node *right;
-	struct hilite_node *prev;
-	struct hilite_node *next;
-	int red;
-	struct hilite r;
-};
-struct hilite_storage
+#define HILITE_BLOCK_SIZE 256
+struct hilite_block
 {
-	int capacity;
 	int used;
-	struct hilite_storage *next;
-	struct hilite_node *nodes;
+	struct hilite r[HILITE_BLOCK_SIZE];
 };
-struct hilite_tree
+struct hilite_list
 {
-	struct hilite_storage *first;
-	struct hilite_storage *current;
-	struct hilite_node *root;
-	struct hilite_node *lookaside;
+	struct hilite_block **blocks;	/* Blocks, in position order */
+	int nblocks;
+	int maxblocks;			/* Allocated size of blocks[] */
+	long count;			/* Number of ranges in all blocks */
+	int lookaside;			/* Block of the last lookup */
 };
-#define HILITE_INITIALIZER() { NULL, NULL, NULL, NULL }
-#define HILITE_LOOKASIDE_STEPS 2
+#define HILITE_INITIALIZER() { NULL, 0, 0, 0, 0 }
+#define BLOCK_END(blk) ((blk)->r[(blk)->used-1].hl_endpos)
 
-static struct hilite_tree hilite_anchor = HILITE_INITIALIZER();
-static struct hilite_tree filter_anchor = HILITE_INITIALIZER();
+/*
+ * When the prep region holds more than this many ranges,
+ * prep_hilite forgets the part furthest from where it is asked to look.
+ */
+#define HILITE_MAX_RANGES 65536
+
+static struct hilite_list hilite_anchor = HILITE_INITIALIZER();
+static struct hilite_list filter_anchor = HILITE_INITIALIZER();
 
 #endif
 
@@ -117,6 +127,86 @@ struct pattern_info {
 static struct pattern_info search_info;
 static struct pattern_info filter_info;
 
+/*
+ * State of an incremental search (--incsearch).
+ */
+static POSITION incr_pos = NULL_POSITION;	/* Where each search starts */
+static int incr_typing = 0;	/* Give up the search if a key is typed? */
+static char *incr_saved = NULL;	/* Search pattern before it began */
+static int incr_saved_type;
+
+#if NO_REGEX
+#define is_literal(search_type) 1
+#else
+#define is_literal(search_type) ((search_type) & SRCH_NO_REGEX)
+#endif
+
+/*
+ * A line read from the file, as seen by the pattern matchers.
+ */
+struct mline {
+	char *raw;		/* The line as read from the file */
+	int raw_len;
+	int cvt_ops;		/* Conversions to do before matching */
+	int converted;		/* Have text, len and chpos been set? */
+	char *text;		/* The converted line */
+	int len;
+	int *chpos;		/* Offset in raw of each char in text, or NULL */
+};
+
+/*
+ * A buffer for converted lines, reused from line to line.
+ */
+struct cvt_buffer {
+	char *buf;
+	int *chpos;
+	int size;
+};
+#define CVT_BUFFER_INITIALIZER() { NULL, NULL, 0 }
+
+static struct cvt_buffer match_cvt = CVT_BUFFER_INITIALIZER();
+
+#if HILITE_SEARCH
+/*
+ * Extra patterns given by --highlight, each displayed with its own
+ * attribute and kept in its own hilite list.  All the literal words
+ * are found by one Aho-Corasick scan of each line, and the regular
+ * expressions are joined into one alternation for each case mode,
+ * so adding words does not add passes over the line.
+ */
+#define NHWORDS 8
+#if NO_REGEX || HAVE_RE_COMP || HAVE_REGCMP
+#define HWORD_REGEX 0		/* Can't join patterns; match words literally */
+#else
+#define HWORD_REGEX 1
+#endif
+struct hword {
+	char *text;
+	int literal;		/* Found by the Aho-Corasick scan? */
+	int caseless;
+	int attr;		/* Attribute it is displayed with */
+#if HWORD_REGEX
+	DEFINE_PATTERN(compiled);
+#endif
+	struct hilite_list anchor;
+};
+static struct hword hwords[NHWORDS];
+static int nhwords = 0;
+static int hword_attrs[NHWORDS] = {
+	AT_UNDERLINE, AT_BOLD, AT_BLINK,
+	AT_UNDERLINE|AT_BOLD, AT_UNDERLINE|AT_BLINK, AT_BOLD|AT_BLINK,
+	AT_STANDOUT|AT_UNDERLINE, AT_STANDOUT|AT_BOLD
+};
+static void *hword_ac = NULL;		/* Automaton for the literal words */
+static int hword_lit[NHWORDS];		/* Word for each automaton string */
+#if HWORD_REGEX
+static DEFINE_PATTERN(hword_re[2]);	/* Exact and caseless alternations */
+static char *hword_retext[2];
+#endif
+static struct cvt_buffer hword_cvt[2] =
+	{ CVT_BUFFER_INITIALIZER(), CVT_BUFFER_INITIALIZER() };
+#endif
+
 /*
  * Are there any uppercase letters in this string?
  */
@@ -136,6 +226,116 @@ is_ucase(str)
 	return (0);
 }
 
+/*
+ * Could a pattern match anything but itself as a regular expression?
+ */
+	static int
+has_regex_meta(str)
+	char *str;
+{
+	return (strpbrk(str, "\\^$.[]|()*+?{}") != NULL);
+}
+
+#if HILITE_SEARCH
+/*
+ * Discard the compiled forms of the --highlight words.
+ */
+	static void
+uncompile_hwords()
+{
+#if HWORD_REGEX
+	int k;
+#endif
+
+	if (hword_ac != NULL)
+		ac_free(hword_ac);
+	hword_ac = NULL;
+#if HWORD_REGEX
+	for (k = 0;  k < 2;  k++)
+	{
+		uncompile_pattern(&hword_re[k]);
+		if (hword_retext[k] != NULL)
+			free(hword_retext[k]);
+		hword_retext[k] = NULL;
+	}
+	for (k = 0;  k < nhwords;  k++)
+		uncompile_pattern(&hwords[k].compiled);
+#endif
+}
+
+/*
+ * Compile the --highlight words: build the automaton which finds
+ * the literal ones, and join the others into an alternation for
+ * each case mode.  The case of a word follows -i and -I the same
+ * way the case of a search pattern does.
+ */
+	static void
+compile_hwords()
+{
+	char *words[NHWORDS];
+	int fold[NHWORDS];
+	int nlit = 0;
+	struct hword *hw;
+	int k;
+#if HWORD_REGEX
+	int len[2];
+	int mode;
+#endif
+
+	uncompile_hwords();
+#if HWORD_REGEX
+	len[0] = len[1] = 0;
+#endif
+	for (k = 0;  k < nhwords;  k++)
+	{
+		hw = &hwords[k];
+		hw->caseless = (caseless == OPT_ONPLUS ||
+			(caseless == OPT_ON && !is_ucase(hw->text)));
+#if HWORD_REGEX
+		hw->literal = !has_regex_meta(hw->text);
+		if (!hw->literal)
+		{
+			if (compile_pattern(hw->text, 0, &hw->compiled) == 0)
+				len[hw->caseless] += (int) strlen(hw->text) + 3;
+			continue;
+		}
+#else
+		hw->literal = 1;
+#endif
+		hword_lit[nlit] = k;
+		words[nlit] = hw->text;
+		fold[nlit] = hw->caseless;
+		nlit++;
+	}
+	if (nlit > 0)
+		hword_ac = ac_compile(words, nlit, fold);
+
+#if HWORD_REGEX
+	for (mode = 0;  mode < 2;  mode++)
+	{
+		if (len[mode] == 0)
+			continue;
+		/* Join the words as (w1)|(w2)|... */
+		hword_retext[mode] = (char *) ecalloc(1, len[mode]);
+		for (k = 0;  k < nhwords;  k++)
+		{
+			hw = &hwords[k];
+			if (hw->literal || hw->caseless != mode ||
+			    is_null_pattern(hw->compiled))
+				continue;
+			if (hword_retext[mode][0] != '\0')
+				strcat(hword_retext[mode], "|");
+			strcat(hword_retext[mode], "(");
+			strcat(hword_retext[mode], hw->text);
+			strcat(hword_retext[mode], ")");
+		}
+		if (compile_pattern(hword_retext[mode], 0, &hword_re[mode]) < 0)
+			CLEAR_PATTERN(hword_re[mode]);
+	}
+#endif
+}
+#endif
+
 /*
  * Compile and save a search pattern.
  */
@@ -150,6 +350,9 @@ set_pattern(info, pattern, search_type)
 		CLEAR_PATTERN(info->compiled);
 	else if (compile_pattern(pattern, search_type, &info->compiled) < 0)
 		return -1;
+#endif
+#if HILITE_SEARCH
+	hilite_gen++;
 #endif
 	/* Pattern compiled successfully; save the text too. */
 	if (info->text != NULL)
@@ -181,6 +384,9 @@ set_pattern(info, pattern, search_type)
 clear_pattern(info)
 	struct pattern_info *info;
 {
+#if HILITE_SEARCH
+	hilite_gen++;
+#endif
 	if (info->text != NULL)
 		free(info->text);
 	info->text = NULL;
@@ -364,156 +570,181 @@ undo_search()
  */
 	public void
 clr_hlist(anchor)
-	struct hilite_tree *anchor;
+	struct hilite_list *anchor;
 {
-	struct hilite_storage *hls;
-	struct hilite_storage *nexthls;
-
-	for (hls = anchor->first;  hls != NULL;  hls = nexthls)
-	{
-		nexthls = hls->next;
-		free((void*)hls->nodes);
-		free((void*)hls);
-	}
-	anchor->first = NULL;
-	anchor->current = NULL;
-	anchor->root = NULL;
-
-	anchor->lookaside = NULL;
-
-	prep_startpos = prep_endpos = NULL_POSITION;
+	int b;
+
+	for (b = 0;  b < anchor->nblocks;  b++)
+		free((void*)anchor->blocks[b]);
+	if (anchor->blocks != NULL)
+		free((void*)anchor->blocks);
+	anchor->blocks = NULL;
+	anchor->nblocks = 0;
+	anchor->maxblocks = 0;
+	anchor->count = 0;
+	anchor->lookaside = 0;
 }
 
 	public void
 clr_hilite()
 {
+	int k;
+
 	clr_hlist(&hilite_anchor);
+	for (k = 0;  k < nhwords;  k++)
+		clr_hlist(&hwords[k].anchor);
+	prep_startpos = prep_endpos = NULL_POSITION;
 }
 
 	public void
 clr_filter()
 {
 	clr_hlist(&filter_anchor);
+	prep_startpos = prep_endpos = NULL_POSITION;
 }
 
-	struct hilite_node*
-hlist_last(anchor)
-	struct hilite_tree *anchor;
-{
-	struct hilite_node *n = anchor->root;
-	while (n != NULL && n->right != NULL)
-		n = n->right;
-	return n;
-}
+/*
+ * The hilite and filter lists of a file which is not being edited.
+ */
+struct hilite_save {
+	struct hilite_list hs_hilite;
+	struct hilite_list hs_filter;
+	struct hilite_list hs_words[NHWORDS];
+	POSITION hs_startpos;
+	POSITION hs_endpos;
+	int hs_gen;
+};
 
-	struct hilite_node*
-hlist_next(n)
-	struct hilite_node *n;
+/*
+ * Take the hilite and filter lists away from the current file,
+ * so they can be restored if it is edited again.
+ */
+	public void *
+save_hilite()
 {
-	return n->next;
+	struct hilite_save *hs;
+	static struct hilite_list empty = HILITE_INITIALIZER();
+	int k;
+
+	hs = (struct hilite_save *) ecalloc(1, sizeof(struct hilite_save));
+	hs->hs_hilite = hilite_anchor;
+	hs->hs_filter = filter_anchor;
+	for (k = 0;  k < nhwords;  k++)
+	{
+		hs->hs_words[k] = hwords[k].anchor;
+		hwords[k].anchor = empty;
+	}
+	hs->hs_startpos = prep_startpos;
+	hs->hs_endpos = prep_endpos;
+	hs->hs_gen = hilite_gen;
+	hilite_anchor = filter_anchor = empty;
+	prep_startpos = prep_endpos = NULL_POSITION;
+	return ((void *) hs);
 }
 
-	struct hilite_node*
-hlist_prev(n)
-	struct hilite_node *n;
+/*
+ * Give the current file the lists saved by save_hilite,
+ * unless the search or filter pattern has changed since then,
+ * and free the saved copy.
+ */
+	public void
+restore_hilite(save, use)
+	void *save;
+	int use;
 {
-	return n->prev;
+	struct hilite_save *hs = (struct hilite_save *) save;
+	int k;
+
+	if (use && hs->hs_gen == hilite_gen)
+	{
+		clr_hilite();
+		clr_filter();
+		hilite_anchor = hs->hs_hilite;
+		filter_anchor = hs->hs_filter;
+		for (k = 0;  k < nhwords;  k++)
+			hwords[k].anchor = hs->hs_words[k];
+		prep_startpos = hs->hs_startpos;
+		prep_endpos = hs->hs_endpos;
+	} else
+	{
+		clr_hlist(&hs->hs_hilite);
+		clr_hlist(&hs->hs_filter);
+		for (k = 0;  k < NHWORDS;  k++)
+			clr_hlist(&hs->hs_words[k]);
+	}
+	free(hs);
 }
 
 /*
- * Find the node covering pos, or the node after it if no node covers it,
- * or return NULL if pos is after the last range. Remember the found node,
- * to speed up subsequent searches for the same or similar positions (if
- * we return NULL, remember the last node.)
+ * Find the first range which ends after pos.
+ * Set *pb to its block and *pi to its index in the block.
+ * Return 0 if pos is after the last range.
  */
-	struct hilite_node*
-hlist_find(anchor, pos)
-	struct hilite_tree *anchor;
+	static int
+hlist_locate(anchor, pos, pb, pi)
+	struct hilite_list *anchor;
 	POSITION pos;
+	int *pb;
+	int *pi;
 {
-	struct hilite_node *n, *m;
+	struct hilite_block *blk;
+	int b = anchor->lookaside;
+	int lo, hi, mid;
 
-	if (anchor->lookaside)
+	if (anchor->nblocks == 0)
+		return (0);
+	if (b >= anchor->nblocks || BLOCK_END(anchor->blocks[b]) <= pos ||
+	    (b > 0 && BLOCK_END(anchor->blocks[b-1]) > pos))
 	{
-		int steps = 0;
-		int hit = 0;
-
-		n = anchor->lookaside;
-
-		for (;;)
+		/* Not in the last block we found; search the blocks. */
+		lo = 0;
+		hi = anchor->nblocks;
+		while (lo < hi)
 		{
-			if (pos < n->r.hl_endpos)
-			{
-				if (n->prev == NULL || pos >= n->prev->r.hl_endpos)
-				{
-					hit = 1;
-					break;
-				}
-			} else if (n->next == NULL)
-			{
-				n = NULL;
-				hit = 1;
-				break;
-			}
-
-			/*
-			 * If we don't find the right node within a small
-			 * distance, don't keep doing a linear search!
-			 */
-			if (steps >= HILITE_LOOKASIDE_STEPS)
-				break;
-			steps++;
-
-			if (pos < n->r.hl_endpos)
-				anchor->lookaside = n = n->prev;
+			mid = (lo + hi) / 2;
+			if (BLOCK_END(anchor->blocks[mid]) > pos)
+				hi = mid;
 			else
-				anchor->lookaside = n = n->next;
+				lo = mid + 1;
 		}
-
-		if (hit)
-			return n;
+		if (lo == anchor->nblocks)
+		{
+			anchor->lookaside = anchor->nblocks - 1;
+			return (0);
+		}
+		b = anchor->lookaside = lo;
 	}
 
-	n = anchor->root;
-	m = NULL;
-
-	while (n != NULL)
+	blk = anchor->blocks[b];
+	lo = 0;
+	hi = blk->used - 1;
+	while (lo < hi)
 	{
-		if (pos < n->r.hl_startpos)
-		{
-			if (n->left != NULL)
-			{
-				m = n;
-				n = n->left;
-				continue;
-			}
-			break;
-		}
-		if (pos >= n->r.hl_endpos)
-		{
-			if (n->right != NULL)
-			{
-				n = n->right;
-				continue;
-			}
-			if (m != NULL)
-			{
-				n = m;
-			} else
-			{
-				m = n;
-				n = NULL;
-			}
-		}
-		break;
+		mid = (lo + hi) / 2;
+		if (blk->r[mid].hl_endpos > pos)
+			hi = mid;
+		else
+			lo = mid + 1;
 	}
+	*pb = b;
+	*pi = lo;
+	return (1);
+}
 
-	if (n != NULL)
-		anchor->lookaside = n;
-	else if (m != NULL)
-		anchor->lookaside = m;
+/*
+ * Find the range covering pos, or the range after it if no range
+ * covers it, or return NULL if pos is after the last range.
+ */
+	static struct hilite *
+hlist_find(anchor, pos)
+	struct hilite_list *anchor;
+	POSITION pos;
+{
+	int b, i;
 
-	return n;
+	if (!hlist_locate(anchor, pos, &b, &i))
+		return (NULL);
+	return (&anchor->blocks[b]->r[i]);
 }
 
 /*
@@ -524,8 +755,8 @@ is_hilited_range(pos, epos)
 	POSITION pos;
 	POSITION epos;
 {
-	struct hilite_node *n = hlist_find(&hilite_anchor, pos);
-	return (n != NULL && (epos == NULL_POSITION || epos > n->r.hl_startpos));
+	struct hilite *n = hlist_find(&hilite_anchor, pos);
+	return (n != NULL && (epos == NULL_POSITION || epos > n->hl_startpos));
 }
 
 /* 
@@ -535,13 +766,13 @@ is_hilited_range(pos, epos)
 is_filtered(pos)
 	POSITION pos;
 {
-	struct hilite_node *n;
+	struct hilite *n;
 
 	if (ch_getflags() & CH_HELPFILE)
 		return (0);
 
 	n = hlist_find(&filter_anchor, pos);
-	return (n != NULL && pos >= n->r.hl_startpos);
+	return (n != NULL && pos >= n->hl_startpos);
 }
 
 /*
@@ -552,16 +783,16 @@ is_filtered(pos)
 next_unfiltered(pos)
 	POSITION pos;
 {
-	struct hilite_node *n;
+	struct hilite *n;
 
 	if (ch_getflags() & CH_HELPFILE)
 		return (pos);
 
 	n = hlist_find(&filter_anchor, pos);
-	while (n != NULL && pos >= n->r.hl_startpos)
+	while (n != NULL && pos >= n->hl_startpos)
 	{
-		pos = n->r.hl_endpos;
-		n = n->next;
+		pos = n->hl_endpos;
+		n = hlist_find(&filter_anchor, pos);
 	}
 	return (pos);
 }
@@ -574,19 +805,19 @@ next_unfiltered(pos)
 prev_unfiltered(pos)
 	POSITION pos;
 {
-	struct hilite_node *n;
+	struct hilite *n;
 
 	if (ch_getflags() & CH_HELPFILE)
 		return (pos);
 
 	n = hlist_find(&filter_anchor, pos);
-	while (n != NULL && pos >= n->r.hl_startpos)
+	while (n != NULL && pos >= n->hl_startpos)
 	{
-		pos = n->r.hl_startpos;
+		pos = n->hl_startpos;
 		if (pos == 0)
 			break;
 		pos--;
-		n = n->prev;
+		n = hlist_find(&filter_anchor, pos);
 	}
 	return (pos);
 }
@@ -643,295 +874,262 @@ is_hilited(pos, epos, nohide, p_matches)
 }
 
 /*
- * Tree node storage: get the current block of nodes if it has spare
- * capacity, or create a new one if not.
+ * Return the attribute of the first --highlight word
+ * which covers a position, or 0 if none does.
  */
-	static struct hilite_storage*
-hlist_getstorage(anchor)
-	struct hilite_tree *anchor;
+	public int
+hilite_attr(pos)
+	POSITION pos;
 {
-	int capacity = 1;
-	struct hilite_storage *s;
+	struct hilite *n;
+	int k;
 
-	if (anchor->current)
+	for (k = 0;  k < nhwords;  k++)
 	{
-		if (anchor->current->used < anchor->current->capacity)
-			return anchor->current;
-		capacity = anchor->current->capacity * 2;
+		n = hlist_find(&hwords[k].anchor, pos);
+		if (n != NULL && pos >= n->hl_startpos)
+			return (hwords[k].attr);
 	}
-
-	s = (struct hilite_storage *) ecalloc(1, sizeof(struct hilite_storage));
-	s->nodes = (struct hilite_node *) ecalloc(capacity, sizeof(struct hilite_node));
-	s->capacity = capacity;
-	s->used = 0;
-	s->next = NULL;
-	if (anchor->current)
-		anchor->current->next = s;
-	else
-		anchor->first = s;
-	anchor->current = s;
-	return s;
-}
-
-/*
- * Tree node storage: retrieve a new empty node to be inserted into the
- * tree.
- */
-	static struct hilite_node*
-hlist_getnode(anchor)
-	struct hilite_tree *anchor;
-{
-	struct hilite_storage *s = hlist_getstorage(anchor);
-	return &s->nodes[s->used++];
+	return (0);
 }
 
 /*
- * Rotate the tree left around a pivot node.
+ * Insert an empty block into a hilite list, before block b.
  */
-	static void
-hlist_rotate_left(anchor, n)
-	struct hilite_tree *anchor;
-	struct hilite_node *n;
+	static struct hilite_block *
+hlist_newblock(anchor, b)
+	struct hilite_list *anchor;
+	int b;
 {
-	struct hilite_node *np = n->parent;
-	struct hilite_node *nr = n->right;
-	struct hilite_node *nrl = n->right->left;
+	struct hilite_block **blocks;
+	struct hilite_block *blk;
 
-	if (np != NULL)
-	{
-		if (n == np->left)
-			np->left = nr;
-		else
-			np->right = nr;
-	} else
+	if (anchor->nblocks == anchor->maxblocks)
 	{
-		anchor->root = nr;
+		anchor->maxblocks = (anchor->maxblocks == 0) ? 16 : anchor->maxblocks * 2;
+		blocks = (struct hilite_block **)
+			ecalloc(anchor->maxblocks, sizeof(struct hilite_block *));
+		if (anchor->blocks != NULL)
+		{
+			memcpy(blocks, anchor->blocks,
+				anchor->nblocks * sizeof(struct hilite_block *));
+			free((void*)anchor->blocks);
+		}
+		anchor->blocks = blocks;
 	}
-	nr->left = n;
-	n->right = nrl;
-
-	nr->parent = np;
-	n->parent = nr;
-	if (nrl != NULL)
-		nrl->parent = n;
+	memmove(&anchor->blocks[b+1], &anchor->blocks[b],
+		(anchor->nblocks - b) * sizeof(struct hilite_block *));
+	blk = (struct hilite_block *) ecalloc(1, sizeof(struct hilite_block));
+	anchor->blocks[b] = blk;
+	anchor->nblocks++;
+	return (blk);
 }
 
 /*
- * Rotate the tree right around a pivot node.
+ * Insert a range into a hilite list at index i of block b.
+ * If i is the number of ranges in the block, append to the block.
  */
 	static void
-hlist_rotate_right(anchor, n)
-	struct hilite_tree *anchor;
-	struct hilite_node *n;
+hlist_insert(anchor, b, i, hl)
+	struct hilite_list *anchor;
+	int b;
+	int i;
+	struct hilite *hl;
 {
-	struct hilite_node *np = n->parent;
-	struct hilite_node *nl = n->left;
-	struct hilite_node *nlr = n->left->right;
+	struct hilite_block *blk;
+	struct hilite_block *nblk;
+	int half;
 
-	if (np != NULL)
+	if (anchor->nblocks == 0)
 	{
-		if (n == np->right)
-			np->right = nl;
-		else
-			np->left = nl;
+		blk = hlist_newblock(anchor, 0);
+		i = 0;
 	} else
 	{
-		anchor->root = nl;
+		/* Appending to the previous block is cheaper than inserting. */
+		if (i == 0 && b > 0 && anchor->blocks[b-1]->used < HILITE_BLOCK_SIZE)
+		{
+			b--;
+			i = anchor->blocks[b]->used;
+		}
+		blk = anchor->blocks[b];
 	}
-	nl->right = n;
-	n->left = nlr;
-
-	nl->parent = np;
-	n->parent = nl;
-	if (nlr != NULL)
-		nlr->parent = n;
+	if (blk->used == HILITE_BLOCK_SIZE)
+	{
+		if (i == blk->used)
+		{
+			/* Appending to a full block: start a new one. */
+			blk = hlist_newblock(anchor, b+1);
+			i = 0;
+		} else
+		{
+			/* Split the block in half. */
+			nblk = hlist_newblock(anchor, b+1);
+			half = blk->used / 2;
+			nblk->used = blk->used - half;
+			memcpy(nblk->r, &blk->r[half], nblk->used * sizeof(struct hilite));
+			blk->used = half;
+			if (i > half)
+			{
+				blk = nblk;
+				i -= half;
+			}
+		}
+	}
+	memmove(&blk->r[i+1], &blk->r[i], (blk->used - i) * sizeof(struct hilite));
+	blk->r[i] = *hl;
+	blk->used++;
+	anchor->count++;
 }
 
-
 /*
  * Add a new hilite to a hilite list.
  */
 	static void
 add_hilite(anchor, hl)
-	struct hilite_tree *anchor;
+	struct hilite_list *anchor;
 	struct hilite *hl;
 {
-	struct hilite_node *p, *n, *u;
+	struct hilite *prev, *next;
+	int b, i;
 
 	/* Ignore empty ranges. */
 	if (hl->hl_startpos >= hl->hl_endpos)
 		return;
 
-	p = anchor->root;
-
-	/* Inserting the very first node is trivial. */
-	if (p == NULL)
+	if (!hlist_locate(anchor, hl->hl_startpos, &b, &i))
 	{
-		n = hlist_getnode(anchor);
-		n->r = *hl;
-		anchor->root = n;
-		anchor->lookaside = n;
-		return;
-	}
-
-	/*
-	 * Find our insertion point. If we come across any overlapping
-	 * or adjoining existing ranges, shrink our range and discard
-	 * if it become empty.
-	 */
-	for (;;)
-	{
-		if (hl->hl_startpos < p->r.hl_startpos)
+		/*
+		 * The new range is after all the others (the usual case).
+		 * Extend the last range if they are contiguous,
+		 * otherwise append the new range.
+		 */
+		b = anchor->nblocks - 1;
+		i = 0;
+		if (b >= 0)
 		{
-			if (hl->hl_endpos > p->r.hl_startpos)
-				hl->hl_endpos = p->r.hl_startpos;
-			if (p->left != NULL)
+			i = anchor->blocks[b]->used;
+			prev = &anchor->blocks[b]->r[i-1];
+			if (prev->hl_endpos == hl->hl_startpos)
 			{
-				p = p->left;
-				continue;
-			}
-			break;
-		}
-		if (hl->hl_startpos < p->r.hl_endpos) {
-			hl->hl_startpos = p->r.hl_endpos;
-			if (hl->hl_startpos >= hl->hl_endpos)
+				prev->hl_endpos = hl->hl_endpos;
 				return;
+			}
 		}
-		if (p->right != NULL)
-		{
-			p = p->right;
-			continue;
-		}
-		break;
+		hlist_insert(anchor, b, i, hl);
+		return;
 	}
 
 	/*
-	 * Now we're at the right leaf, again check for contiguous ranges
-	 * and extend the existing node if possible to avoid the
-	 * insertion. Otherwise insert a new node at the leaf.
+	 * (b,i) is the first range which ends after our start.
+	 * While it covers our start, shrink our range to start after it,
+	 * and discard our range if it becomes empty.
 	 */
-	if (hl->hl_startpos < p->r.hl_startpos) {
-		if (hl->hl_endpos == p->r.hl_startpos)
-		{
-			p->r.hl_startpos = hl->hl_startpos;
-			return;
-		}
-		if (p->prev != NULL && p->prev->r.hl_endpos == hl->hl_startpos)
-		{
-			p->prev->r.hl_endpos = hl->hl_endpos;
+	for (;;)
+	{
+		next = (b < anchor->nblocks) ? &anchor->blocks[b]->r[i] : NULL;
+		if (next == NULL || next->hl_startpos > hl->hl_startpos)
+			break;
+		hl->hl_startpos = next->hl_endpos;
+		if (hl->hl_startpos >= hl->hl_endpos)
 			return;
-		}
-
-		p->left = n = hlist_getnode(anchor);
-		n->next = p;
-		if (p->prev != NULL)
+		if (++i == anchor->blocks[b]->used)
 		{
-			n->prev = p->prev;
-			p->prev->next = n;
+			b++;
+			i = 0;
 		}
-		p->prev = n;
-	} else {
-		if (p->r.hl_endpos == hl->hl_startpos)
-		{
-			p->r.hl_endpos = hl->hl_endpos;
-			return;
-		}
-		if (p->next != NULL && hl->hl_endpos == p->next->r.hl_startpos) {
-			p->next->r.hl_startpos = hl->hl_startpos;
-			return;
-		}
-
-		p->right = n = hlist_getnode(anchor);
-		n->prev = p;
-		if (p->next != NULL)
-		{
-			n->next = p->next;
-			p->next->prev = n;
-		}
-		p->next = n;
 	}
-	n->parent = p;
-	n->red = 1;
-	n->r = *hl;
+	/* Now we go between the ranges before and at (b,i). */
+	if (i > 0)
+		prev = &anchor->blocks[b]->r[i-1];
+	else if (b > 0)
+		prev = &anchor->blocks[b-1]->r[anchor->blocks[b-1]->used-1];
+	else
+		prev = NULL;
+	if (next != NULL && hl->hl_endpos > next->hl_startpos)
+		hl->hl_endpos = next->hl_startpos;
 
 	/*
-	 * The tree is in the correct order and covers the right ranges
-	 * now, but may have become unbalanced. Rebalance it using the
-	 * standard red-black tree constraints and operations.
+	 * Extend an existing range if ours is contiguous with it,
+	 * to avoid the insertion.  Otherwise insert a new range.
 	 */
-	for (;;)
+	if (prev != NULL && prev->hl_endpos == hl->hl_startpos)
 	{
-		/* case 1 - current is root, root is always black */
-		if (n->parent == NULL)
-		{
-			n->red = 0;
-			break;
-		}
-
-		/* case 2 - parent is black, we can always be red */
-		if (!n->parent->red)
-			break;
+		prev->hl_endpos = hl->hl_endpos;
+		return;
+	}
+	if (next != NULL && next->hl_startpos == hl->hl_endpos)
+	{
+		next->hl_startpos = hl->hl_startpos;
+		return;
+	}
+	if (next == NULL)
+	{
+		b--;
+		i = anchor->blocks[b]->used;
+	}
+	hlist_insert(anchor, b, i, hl);
+}
 
-		/*
-		 * constraint: because the root must be black, if our
-		 * parent is red it cannot be the root therefore we must
-		 * have a grandparent
-		 */
+/*
+ * Forget the ranges in a hilite list which end at or before spos,
+ * and those which start at or after epos.
+ * Either position may be NULL_POSITION to keep that end of the list.
+ */
+	static void
+hlist_trim(anchor, spos, epos)
+	struct hilite_list *anchor;
+	POSITION spos;
+	POSITION epos;
+{
+	struct hilite_block *blk;
+	int b, i, nb;
 
-		/*
-		 * case 3 - parent and uncle are red, repaint them black,
-		 * the grandparent red, and start again at the grandparent.
-		 */
-		u = n->parent->parent->left;
-		if (n->parent == u) 
-			u = n->parent->parent->right;
-		if (u != NULL && u->red)
+	if (spos != NULL_POSITION)
+	{
+		if (!hlist_locate(anchor, spos, &b, &i))
 		{
-			n->parent->red = 0;
-			u->red = 0;
-			n = n->parent->parent;
-			n->red = 1;
-			continue;
+			b = anchor->nblocks;
+			i = 0;
 		}
-
-		/*
-		 * case 4 - parent is red but uncle is black, parent and
-		 * grandparent on opposite sides. We need to start
-		 * changing the structure now. This and case 5 will shorten
-		 * our branch and lengthen the sibling, between them
-		 * restoring balance.
-		 */
-		if (n == n->parent->right &&
-		    n->parent == n->parent->parent->left)
-		{
-			hlist_rotate_left(anchor, n->parent);
-			n = n->left;
-		} else if (n == n->parent->left &&
-			   n->parent == n->parent->parent->right)
+		/* Free the blocks before b, and shift down the rest. */
+		for (nb = 0;  nb < b;  nb++)
+			free((void*)anchor->blocks[nb]);
+		memmove(&anchor->blocks[0], &anchor->blocks[b],
+			(anchor->nblocks - b) * sizeof(struct hilite_block *));
+		anchor->nblocks -= b;
+		if (i > 0)
 		{
-			hlist_rotate_right(anchor, n->parent);
-			n = n->right;
+			blk = anchor->blocks[0];
+			blk->used -= i;
+			memmove(&blk->r[0], &blk->r[i], blk->used * sizeof(struct hilite));
 		}
-
-		/*
-		 * case 5 - parent is red but uncle is black, parent and
-		 * grandparent on same side
-		 */
-		n->parent->red = 0;
-		n->parent->parent->red = 1;
-		if (n == n->parent->left)
-			hlist_rotate_right(anchor, n->parent->parent);
-		else
-			hlist_rotate_left(anchor, n->parent->parent);
-		break;
 	}
+	if (epos != NULL_POSITION && hlist_locate(anchor, epos, &b, &i))
+	{
+		blk = anchor->blocks[b];
+		if (blk->r[i].hl_startpos < epos)
+			i++;
+		blk->used = i;
+		/* Free the blocks after b, and b too if it is now empty. */
+		nb = (i == 0) ? b : b+1;
+		for (b = nb;  b < anchor->nblocks;  b++)
+			free((void*)anchor->blocks[b]);
+		anchor->nblocks = nb;
+	}
+	anchor->count = 0;
+	for (b = 0;  b < anchor->nblocks;  b++)
+		anchor->count += anchor->blocks[b]->used;
+	anchor->lookaside = 0;
 }
 
 /*
- * Hilight every character in a range of displayed characters.
+ * Hilight every character in a range of displayed characters,
+ * adding the hilites to a given list.
  */
 	static void
-create_hilites(linepos, start_index, end_index, chpos)
+create_hilites(anchor, linepos, start_index, end_index, chpos)
+	struct hilite_list *anchor;
 	POSITION linepos;
 	int start_index;
 	int end_index;
@@ -940,6 +1138,18 @@ create_hilites(linepos, start_index, end_index, chpos)
 	struct hilite hl;
 	int i;
 
+	if (chpos == NULL)
+	{
+		/* The indexes are offsets in the unconverted line. */
+		if (end_index > start_index)
+		{
+			hl.hl_startpos = linepos + start_index;
+			hl.hl_endpos = linepos + end_index;
+			add_hilite(anchor, &hl);
+		}
+		return;
+	}
+
 	/* Start the first hilite. */
 	hl.hl_startpos = linepos + chpos[start_index];
 
@@ -956,7 +1166,7 @@ create_hilites(linepos, start_index, end_index, chpos)
 		if (chpos[i] != chpos[i-1] + 1 || i == end_index)
 		{
 			hl.hl_endpos = linepos + chpos[i-1] + 1;
-			add_hilite(&hilite_anchor, &hl);
+			add_hilite(anchor, &hl);
 			/* Start new hilite unless this is the last char. */
 			if (i < end_index)
 			{
@@ -970,6 +1180,7 @@ create_hilites(linepos, start_index, end_index, chpos)
  * Make a hilite for each string in a physical line which matches 
  * the current pattern.
  * sp,ep delimit the first match already found.
+ * If chpos is NULL, line is the unconverted line.
  */
 	static void
 hilite_line(linepos, line, line_len, chpos, sp, ep, cvt_ops)
@@ -992,13 +1203,13 @@ hilite_line(linepos, line, line_len, chpos, sp, ep, cvt_ops)
 	 *    substrings of the line, may mark more than is correct
 	 *    if the pattern starts with "^".  This bug is fixed
 	 *    for those regex functions that accept a notbol parameter
-	 *    (currently POSIX, PCRE and V8-with-regexec2). }}
+	 *    (currently POSIX, PCRE, PCRE2 and V8-with-regexec2). }}
 	 */
 	searchp = line;
 	do {
 		if (sp == NULL || ep == NULL)
 			return;
-		create_hilites(linepos, sp-line, ep-line, chpos);
+		create_hilites(&hilite_anchor, linepos, sp-line, ep-line, chpos);
 		/*
 		 * If we matched more than zero characters,
 		 * move to the first char after the string we matched.
@@ -1010,7 +1221,10 @@ hilite_line(linepos, line, line_len, chpos, sp, ep, cvt_ops)
 			searchp++;
 		else /* end of line */
 			break;
-	} while (match_pattern(info_compiled(&search_info), search_info.text,
+	} while (is_literal(search_info.search_type) ?
+		match_literal(search_info.text, searchp, line_end - searchp,
+			&sp, &ep, cvt_ops, search_info.search_type) :
+		match_pattern(info_compiled(&search_info), search_info.text,
 			searchp, line_end - searchp, &sp, &ep, 1, search_info.search_type));
 }
 #endif
@@ -1042,6 +1256,7 @@ chg_hilite()
 	 */
 	clr_hilite();
 	hide_hilite = 0;
+	hilite_gen++;
 
 	if (hilite_search == OPT_ONPLUS)
 		/*
@@ -1126,29 +1341,227 @@ search_pos(search_type)
 	 */
 	if (search_type & SRCH_FORW) 
 	{
-		while (pos == NULL_POSITION)
+		while (pos == NULL_POSITION)
+		{
+			if (++linenum >= sc_height)
+				break;
+			pos = position(linenum);
+		}
+	} else 
+	{
+		while (pos == NULL_POSITION)
+		{
+			if (--linenum < 0)
+				break;
+			pos = position(linenum);
+		}
+	}
+	return (pos);
+}
+
+/*
+ * Convert a line read from the file, if the conversions would change
+ * anything, and set *ptext, *plen and *pchpos to describe the result.
+ * *pchpos is set to NULL if the line is used as it is.
+ */
+	static void
+convert_line(cb, raw, raw_len, cvt_ops, ptext, plen, pchpos)
+	struct cvt_buffer *cb;
+	char *raw;
+	int raw_len;
+	int cvt_ops;
+	char **ptext;
+	int *plen;
+	int **pchpos;
+{
+	int size;
+	int i;
+
+	if (!cvt_needed(raw, raw_len, cvt_ops))
+	{
+		*ptext = raw;
+		*plen = raw_len;
+		*pchpos = NULL;
+		return;
+	}
+	size = cvt_length(raw_len, cvt_ops);
+	if (size > cb->size)
+	{
+		if (cb->buf != NULL)
+		{
+			free(cb->buf);
+			free(cb->chpos);
+		}
+		if (cb->size == 0)
+			cb->size = 1024;
+		while (cb->size < size)
+			cb->size *= 2;
+		cb->buf = (char *) ecalloc(1, cb->size);
+		cb->chpos = (int *) ecalloc(sizeof(int), cb->size);
+	}
+	/* Initialize all entries to an invalid position. */
+	for (i = 0;  i < size;  i++)
+		cb->chpos[i] = -1;
+	*plen = raw_len;
+	cvt_text(cb->buf, raw, cb->chpos, plen, cvt_ops);
+	*ptext = cb->buf;
+	*pchpos = cb->chpos;
+}
+
+/*
+ * Match a pattern against a line read from the file.
+ * Literal patterns are matched against the line as read, with the
+ * text conversions done during the match.  Regular expressions are
+ * matched against the converted line, which is built only once per
+ * line and only if the conversions would change anything.
+ * On return, *pline, *pline_len and *pchpos describe the text which
+ * sp and ep point into.
+ */
+	static int
+match_mline(info, search_type, ml, sp, ep, pline, pline_len, pchpos)
+	struct pattern_info *info;
+	int search_type;
+	struct mline *ml;
+	char **sp;
+	char **ep;
+	char **pline;
+	int *pline_len;
+	int **pchpos;
+{
+	if (is_literal(search_type))
+	{
+		*pline = ml->raw;
+		*pline_len = ml->raw_len;
+		*pchpos = NULL;
+		return (match_literal(info->text, ml->raw, ml->raw_len,
+			sp, ep, ml->cvt_ops, search_type));
+	}
+	if (!ml->converted)
+	{
+		ml->converted = 1;
+		convert_line(&match_cvt, ml->raw, ml->raw_len, ml->cvt_ops,
+			&ml->text, &ml->len, &ml->chpos);
+	}
+	*pline = ml->text;
+	*pline_len = ml->len;
+	*pchpos = ml->chpos;
+	return (match_pattern(info_compiled(info), info->text,
+		ml->text, ml->len, sp, ep, 0, search_type));
+}
+
+#if HILITE_SEARCH
+/*
+ * Where a line being scanned for --highlight words came from.
+ */
+struct hword_scan {
+	POSITION linepos;
+	char *text;
+	int *chpos;
+};
+
+/*
+ * Called by ac_scan for each literal word found in a line.
+ */
+	static void
+hword_found(which, sp, ep, arg)
+	int which;
+	char *sp;
+	char *ep;
+	void *arg;
+{
+	struct hword_scan *scan = (struct hword_scan *) arg;
+
+	create_hilites(&hwords[hword_lit[which]].anchor, scan->linepos,
+		sp - scan->text, ep - scan->text, scan->chpos);
+}
+
+#if HWORD_REGEX
+/*
+ * Find the matches of one of the regular expression alternations
+ * in a converted line.  Each match is credited to the first word
+ * in the alternation which itself matches at the same place.
+ */
+	static void
+hilite_hword_re(mode, scan, len)
+	int mode;
+	struct hword_scan *scan;
+	int len;
+{
+	char *line = scan->text;
+	char *line_end = line + len;
+	char *searchp;
+	char *sp, *ep;
+	char *wsp, *wep;
+	struct hword *hw;
+	int k;
+
+	searchp = line;
+	while (match_pattern(hword_re[mode], hword_retext[mode], searchp,
+			line_end - searchp, &sp, &ep, searchp > line, 0))
+	{
+		for (k = 0;  k < nhwords;  k++)
 		{
-			if (++linenum >= sc_height)
+			hw = &hwords[k];
+			if (hw->literal || hw->caseless != mode)
+				continue;
+			if (match_pattern(hw->compiled, hw->text, sp,
+				    line_end - sp, &wsp, &wep, sp > line, 0) &&
+			    wsp == sp)
+			{
+				create_hilites(&hw->anchor, scan->linepos,
+					sp - line, ep - line, scan->chpos);
 				break;
-			pos = position(linenum);
+			}
 		}
-	} else 
+		if (ep > searchp)
+			searchp = ep;
+		else if (searchp != line_end)
+			searchp++;
+		else /* end of line */
+			break;
+	}
+}
+#endif
+
+/*
+ * Make hilites for every --highlight word in a line.
+ * The line is converted as for a case-sensitive search,
+ * and converted again to lowercase only if a caseless
+ * regular expression needs it.
+ */
+	static void
+hilite_words(linepos, line, line_len)
+	POSITION linepos;
+	char *line;
+	int line_len;
+{
+	struct hword_scan scan;
+	int cvt_ops = get_cvt_ops() & ~CVT_TO_LC;
+	int len;
+
+	scan.linepos = linepos;
+	convert_line(&hword_cvt[0], line, line_len, cvt_ops,
+		&scan.text, &len, &scan.chpos);
+	if (hword_ac != NULL)
+		ac_scan(hword_ac, scan.text, len, hword_found, (void *) &scan);
+#if HWORD_REGEX
+	if (!is_null_pattern(hword_re[0]))
+		hilite_hword_re(0, &scan, len);
+	if (!is_null_pattern(hword_re[1]))
 	{
-		while (pos == NULL_POSITION)
-		{
-			if (--linenum < 0)
-				break;
-			pos = position(linenum);
-		}
+		convert_line(&hword_cvt[1], line, line_len, cvt_ops|CVT_TO_LC,
+			&scan.text, &len, &scan.chpos);
+		hilite_hword_re(1, &scan, len);
 	}
-	return (pos);
+#endif
 }
+#endif
 
 /*
  * Search a subset of the file, specified by start/end position.
  */
 	static int
-search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
+search_range2(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 	POSITION pos;
 	POSITION endpos;
 	int search_type;
@@ -1160,13 +1573,14 @@ search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 	char *line;
 	char *cline;
 	int line_len;
+	int cline_len;
 	LINENUM linenum;
 	char *sp, *ep;
 	int line_match;
-	int cvt_ops;
-	int cvt_len;
+	struct mline ml;
 	int *chpos;
 	POSITION linepos, oldpos;
+	int nlines = 0;
 
 	linenum = find_linenum(pos);
 	oldpos = pos;
@@ -1184,6 +1598,14 @@ search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 			 */
 			return (-1);
 		}
+		if (incr_typing && (++nlines % 256) == 0 && tty_pending())
+		{
+			/*
+			 * A key typed during an incremental search
+			 * abandons it; the key will start another.
+			 */
+			return (-1);
+		}
 
 		if ((endpos != NULL_POSITION && pos >= endpos) || maxlines == 0)
 		{
@@ -1228,6 +1650,7 @@ search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 				*pendpos = oldpos;
 			return (matches);
 		}
+		stat_search_lines++;
 
 		/*
 		 * If we're using line numbers, we might as well
@@ -1245,14 +1668,14 @@ search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 			continue;
 
 		/*
-		 * If it's a caseless search, convert the line to lowercase.
-		 * If we're doing backspace processing, delete backspaces.
+		 * If it's a caseless search, the line is matched as if
+		 * converted to lowercase.  If we're doing backspace
+		 * processing, it is matched as if backspaces were deleted.
 		 */
-		cvt_ops = get_cvt_ops();
-		cvt_len = cvt_length(line_len, cvt_ops);
-		cline = (char *) ecalloc(1, cvt_len);
-		chpos = cvt_alloc_chpos(cvt_len);
-		cvt_text(cline, line, chpos, &line_len, cvt_ops);
+		ml.raw = line;
+		ml.raw_len = line_len;
+		ml.cvt_ops = get_cvt_ops();
+		ml.converted = 0;
 
 #if HILITE_SEARCH
 		/*
@@ -1263,8 +1686,8 @@ search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 		     prep_startpos == NULL_POSITION ||
 		     linepos < prep_startpos || linepos >= prep_endpos) &&
 		    prev_pattern(&filter_info)) {
-			int line_filter = match_pattern(info_compiled(&filter_info), filter_info.text,
-				cline, line_len, &sp, &ep, 0, filter_info.search_type);
+			int line_filter = match_mline(&filter_info, filter_info.search_type,
+				&ml, &sp, &ep, &cline, &cline_len, &chpos);
 			if (line_filter)
 			{
 				struct hilite hl;
@@ -1274,6 +1697,9 @@ search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 				continue;
 			}
 		}
+
+		if ((search_type & SRCH_FIND_ALL) && nhwords > 0)
+			hilite_words(linepos, line, line_len);
 #endif
 
 		/*
@@ -1283,8 +1709,8 @@ search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 		 */
 		if (prev_pattern(&search_info))
 		{
-			line_match = match_pattern(info_compiled(&search_info), search_info.text,
-				cline, line_len, &sp, &ep, 0, search_type);
+			line_match = match_mline(&search_info, search_type,
+				&ml, &sp, &ep, &cline, &cline_len, &chpos);
 			if (line_match)
 			{
 				/*
@@ -1298,7 +1724,7 @@ search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 					 * Just add the matches in this line to the 
 					 * hilite list and keep searching.
 					 */
-					hilite_line(linepos, cline, line_len, chpos, sp, ep, cvt_ops);
+					hilite_line(linepos, cline, cline_len, chpos, sp, ep, ml.cvt_ops);
 #endif
 				} else if (--matches <= 0)
 				{
@@ -1314,22 +1740,41 @@ search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
 						 * the matches in this one line.
 						 */
 						clr_hilite();
-						hilite_line(linepos, cline, line_len, chpos, sp, ep, cvt_ops);
+						hilite_line(linepos, cline, cline_len, chpos, sp, ep, ml.cvt_ops);
 					}
 #endif
-					free(cline);
-					free(chpos);
 					if (plinepos != NULL)
 						*plinepos = linepos;
 					return (0);
 				}
 			}
 		}
-		free(cline);
-		free(chpos);
 	}
 }
 
+/*
+ * Search a subset of the file, keeping track of how long it takes.
+ */
+	static int
+search_range(pos, endpos, search_type, matches, maxlines, plinepos, pendpos)
+	POSITION pos;
+	POSITION endpos;
+	int search_type;
+	int matches;
+	int maxlines;
+	POSITION *plinepos;
+	POSITION *pendpos;
+{
+	double t;
+	int result;
+
+	STAT_START(t);
+	result = search_range2(pos, endpos, search_type, matches, maxlines,
+			plinepos, pendpos);
+	STAT_END(t, stat_search_time);
+	return (result);
+}
+
 /*
  * search for a pattern in history. If found, compile that pattern.
  */
@@ -1366,6 +1811,11 @@ hist_pattern(search_type)
 	public void
 chg_caseless()
 {
+#if HILITE_SEARCH
+	hilite_gen++;
+	if (nhwords > 0)
+		compile_hwords();
+#endif
 	if (!is_ucase_pattern)
 		/*
 		 * Pattern did not have uppercase.
@@ -1383,6 +1833,205 @@ chg_caseless()
 	}
 }
 
+#if HAVE_STAT
+/*
+ * Does a line read by file_matches count as a match?
+ */
+	static int
+scan_line(line, line_len, search_type)
+	char *line;
+	int line_len;
+	int search_type;
+{
+	struct mline ml;
+	char *sp, *ep;
+	char *cline;
+	int cline_len;
+	int *chpos;
+
+	stat_search_lines++;
+	ml.raw = line;
+	ml.raw_len = line_len;
+	ml.cvt_ops = get_cvt_ops();
+	ml.converted = 0;
+#if HILITE_SEARCH
+	if (prev_pattern(&filter_info) &&
+	    match_mline(&filter_info, filter_info.search_type,
+			&ml, &sp, &ep, &cline, &cline_len, &chpos))
+		return (0);
+#endif
+	return (match_mline(&search_info, search_type,
+		&ml, &sp, &ep, &cline, &cline_len, &chpos));
+}
+
+/*
+ * Count the lines from p to end which match a literal pattern,
+ * up to maxmatches, by searching them all in one call.
+ * A literal pattern can't match across a newline, so after
+ * each match the search goes on at the next line.
+ */
+	static int
+scan_lines(p, end, search_type, maxmatches)
+	char *p;
+	char *end;
+	int search_type;
+	int maxmatches;
+{
+	char *sp, *ep;
+	int cvt_ops = get_cvt_ops();
+	int count = 0;
+
+	while (p < end && count < maxmatches &&
+	       match_literal(search_info.text, p, end - p,
+			&sp, &ep, cvt_ops, search_type))
+	{
+		count++;
+		p = memchr(sp, '\n', end - sp);
+		if (p == NULL)
+			break;
+		p++;
+	}
+	return (count);
+}
+#endif
+
+/*
+ * Count the lines of a file which match the current search pattern,
+ * up to maxmatches, by reading the file directly instead of editing it.
+ * A search which goes on into other files uses this to pass over files
+ * without a match, without opening each one as the current file.
+ * Return -1 if the file can't be read this way (it isn't a regular
+ * file, or it would be read through LESSOPEN or decompressed),
+ * or if the scan is interrupted; the caller must then edit the file
+ * to search it.
+ */
+	public int
+file_matches(filename, search_type, maxmatches)
+	char *filename;
+	int search_type;
+	int maxmatches;
+{
+#if HAVE_STAT
+	static char *buf = NULL;
+	static char *part = NULL;	/* Start of a line split across reads */
+	static int part_size = 0;
+	int part_len = 0;
+	struct stat statbuf;
+	char *qfilename;
+	char *p, *nl, *end;
+	int f;
+	int n;
+	int count = 0;
+#if HAVE_ZLIB
+	int first = 1;
+#endif
+	int by_block;
+	int result;
+
+#define	SCAN_BUFSIZE	(64*1024)
+
+	if (!prev_pattern(&search_info))
+		return (-1);
+	if (use_lessopen && !secure && lgetenv("LESSOPEN") != NULL)
+		return (-1);
+	qfilename = shell_unquote(filename);
+	f = open(qfilename, OPEN_READ);
+	free(qfilename);
+	if (f < 0)
+		return (-1);
+	if (fstat(f, &statbuf) < 0 || !S_ISREG(statbuf.st_mode))
+	{
+		close(f);
+		return (-1);
+	}
+	if (buf == NULL)
+		buf = (char *) ecalloc(1, SCAN_BUFSIZE);
+	by_block = (is_literal(search_type) || !has_regex_meta(search_info.text)) &&
+		!(search_type & SRCH_NO_MATCH) && !prev_pattern(&filter_info);
+
+	result = -1;
+	for (;;)
+	{
+		if (ABORT_SIGS())
+			break;
+		n = read(f, buf, SCAN_BUFSIZE);
+		if (n < 0)
+			break;
+		if (n == 0)
+		{
+			/* The last line may not end with a newline. */
+			if (part_len > 0)
+				count += scan_line(part, part_len, search_type);
+			result = (count < maxmatches) ? count : maxmatches;
+			break;
+		}
+#if HAVE_ZLIB
+		if (first && decompress && n >= 2 &&
+		    (buf[0] & 0377) == 0x1f && (buf[1] & 0377) == 0x8b)
+			/* A gzip file; it will be decompressed when edited. */
+			break;
+		first = 0;
+#endif
+		end = buf + n;
+		for (p = buf;  p < end;  p = nl + 1)
+		{
+			if (by_block && part_len == 0)
+			{
+				/* Scan all the whole lines in the buffer at once. */
+				for (nl = end;  nl > p && nl[-1] != '\n';  nl--)
+					continue;
+				count += scan_lines(p, nl, search_type, maxmatches - count);
+				if (count >= maxmatches || nl == end)
+					break;
+				p = nl;
+			}
+			nl = memchr(p, '\n', end - p);
+			if (nl == NULL)
+				nl = end;
+			if (part_len > 0 || nl == end)
+			{
+				/*
+				 * Collect the pieces of a line which
+				 * is split across reads.
+				 */
+				if (part_len + (nl - p) > part_size)
+				{
+					char *opart = part;
+					if (part_size == 0)
+						part_size = 1024;
+					while (part_size < part_len + (nl - p))
+						part_size *= 2;
+					part = (char *) ecalloc(1, part_size);
+					if (opart != NULL)
+					{
+						memcpy(part, opart, part_len);
+						free(opart);
+					}
+				}
+				memcpy(part + part_len, p, nl - p);
+				part_len += nl - p;
+				if (nl == end)
+					break;
+				count += scan_line(part, part_len, search_type);
+				part_len = 0;
+			} else
+				count += scan_line(p, nl - p, search_type);
+			if (count >= maxmatches)
+				break;
+		}
+		if (count >= maxmatches)
+		{
+			result = maxmatches;
+			break;
+		}
+	}
+	close(f);
+	return (result);
+#else
+	return (-1);
+#endif
+}
+
 /*
  * Search for the n-th occurrence of a specified pattern, 
  * either forward or backward.
@@ -1469,7 +2118,10 @@ search(search_type, pattern, n)
 	/*
 	 * Figure out where to start the search.
 	 */
-	pos = search_pos(search_type);
+	if ((search_type & SRCH_INCR) && incr_pos != NULL_POSITION)
+		pos = incr_pos;
+	else
+		pos = search_pos(search_type);
 	if (pos == NULL_POSITION)
 	{
 		/*
@@ -1517,8 +2169,170 @@ search(search_type, pattern, n)
 	return (0);
 }
 
+/*
+ * Begin an incremental search, which looks for the pattern again
+ * each time a character of it is typed.  Each search starts from
+ * where the first one would have, rather than from the match
+ * found for the shorter pattern.  Remember the current pattern,
+ * so it can be put back if the incremental search is abandoned.
+ */
+	public void
+incr_search_begin(search_type)
+	int search_type;
+{
+	incr_pos = search_pos(search_type);
+	if (incr_saved != NULL)
+		free(incr_saved);
+	incr_saved = (search_info.text == NULL) ? NULL : save(search_info.text);
+	incr_saved_type = search_info.search_type;
+}
+
+/*
+ * Search for the pattern typed so far in an incremental search.
+ * The search is given up as soon as another key is typed, so that
+ * a slow search never holds up typing.  Return 0 if a match was
+ * found, 1 if not (or if the pattern is not yet a valid one),
+ * and -1 if the search was given up.
+ */
+	public int
+incr_search_step(pattern, search_type)
+	char *pattern;
+	int search_type;
+{
+	int n;
+	int save_bell;
+
+	if (incr_pos == NULL_POSITION)
+		return (1);
+#if !NO_REGEX
+	if (!(search_type & SRCH_NO_REGEX) && !valid_pattern(pattern))
+		return (1);
+#endif
+	/*
+	 * The match is often the one already at the target line,
+	 * which is not a failed attempt to move.
+	 */
+	save_bell = same_pos_bell;
+	same_pos_bell = 0;
+	incr_typing = 1;
+	n = search(search_type | SRCH_INCR, pattern, 1);
+	incr_typing = 0;
+	same_pos_bell = save_bell;
+	return (n);
+}
+
+/*
+ * Abandon an incremental search: put back the search pattern
+ * which was in effect before it began.
+ */
+	public void
+incr_search_undo()
+{
+#if HILITE_SEARCH
+	repaint_hilite(0);
+#endif
+	if (incr_saved == NULL)
+		clear_pattern(&search_info);
+	else
+		(void) set_pattern(&search_info, incr_saved, incr_saved_type);
+#if HILITE_SEARCH
+	clr_hilite();
+	if (hilite_search == OPT_ONPLUS && !hide_hilite)
+		hilite_screen();
+#endif
+}
+
+/*
+ * Finish an incremental search.
+ */
+	public void
+incr_search_end()
+{
+	incr_pos = NULL_POSITION;
+	if (incr_saved != NULL)
+		free(incr_saved);
+	incr_saved = NULL;
+}
+
 
 #if HILITE_SEARCH
+/*
+ * How many ranges are there in all the lists for the prep region?
+ */
+	static long
+prep_count()
+{
+	long count = hilite_anchor.count + filter_anchor.count;
+	int k;
+
+	for (k = 0;  k < nhwords;  k++)
+		count += hwords[k].anchor.count;
+	return (count);
+}
+
+/*
+ * Forget the ranges in all the lists which are outside (spos,epos).
+ */
+	static void
+prep_trim(spos, epos)
+	POSITION spos;
+	POSITION epos;
+{
+	int k;
+
+	hlist_trim(&hilite_anchor, spos, epos);
+	hlist_trim(&filter_anchor, spos, epos);
+	for (k = 0;  k < nhwords;  k++)
+		hlist_trim(&hwords[k].anchor, spos, epos);
+}
+
+/*
+ * If the prep region holds too many hilites, shrink it by cutting off
+ * the side further from the range (spos,epos), and then if necessary
+ * the other side too, and forget the hilites outside it.
+ * spos must be at the start of a line.
+ */
+	static void
+trim_prep(spos, epos)
+	POSITION spos;
+	POSITION epos;
+{
+	POSITION before;
+	POSITION after;
+	POSITION cut;
+
+	if (prep_startpos == NULL_POSITION ||
+	    (prep_endpos != NULL_POSITION && spos > prep_endpos) ||
+	    (epos != NULL_POSITION && epos < prep_startpos))
+		/* prep_hilite will discard the whole region anyway. */
+		return;
+
+	while (prep_count() > HILITE_MAX_RANGES)
+	{
+		before = after = 0;
+		if (spos > prep_startpos)
+			before = spos - prep_startpos;
+		if (epos != NULL_POSITION && prep_endpos != NULL_POSITION &&
+		    prep_endpos > epos)
+			after = prep_endpos - epos;
+
+		if (before > 0 && before >= after)
+		{
+			prep_trim(spos, NULL_POSITION);
+			prep_startpos = spos;
+		} else if (after > 0)
+		{
+			/* Cut at the start of the line containing epos. */
+			cut = back_raw_line(epos+1, (char **)NULL, (int *)NULL);
+			if (cut == NULL_POSITION || cut <= prep_startpos)
+				break;
+			prep_trim(NULL_POSITION, cut);
+			prep_endpos = cut;
+		} else
+			break;
+	}
+}
+
 /*
  * Prepare hilites in a given range of the file.
  *
@@ -1548,7 +2362,7 @@ prep_hilite(spos, epos, maxlines)
  */
 #define	SEARCH_MORE (3*size_linebuf)
 
-	if (!prev_pattern(&search_info) && !is_filtering())
+	if (!prev_pattern(&search_info) && !is_filtering() && nhwords == 0)
 		return;
 
 	/*
@@ -1557,6 +2371,13 @@ prep_hilite(spos, epos, maxlines)
 	 */
 	spos = back_raw_line(spos+1, (char **)NULL, (int *)NULL);
 
+	/*
+	 * Don't let the prep region collect too many hilites.
+	 */
+	trim_prep(spos, epos);
+	nprep_startpos = prep_startpos;
+	nprep_endpos = prep_endpos;
+
 	/*
 	 * If we're limited to a max number of lines, figure out the
 	 * file position we should stop at.
@@ -1722,6 +2543,68 @@ is_filtering()
 		return (0);
 	return prev_pattern(&filter_info);
 }
+
+/*
+ * Add a pattern to the words highlighted by --highlight.
+ * Return -1 if there are already as many words as we can show.
+ */
+	public int
+add_hword(pattern)
+	char *pattern;
+{
+	if (nhwords >= NHWORDS)
+		return (-1);
+	/* Rescan the prep region for the new word. */
+	clr_hilite();
+	hwords[nhwords].text = save(pattern);
+	hwords[nhwords].attr = hword_attrs[nhwords];
+	nhwords++;
+	compile_hwords();
+	hilite_gen++;
+	screen_trashed = 1;
+	return (0);
+}
+
+/*
+ * Stop highlighting all --highlight words.
+ */
+	public void
+clr_hwords()
+{
+	int k;
+
+	clr_hilite();
+	uncompile_hwords();
+	for (k = 0;  k < nhwords;  k++)
+	{
+		free(hwords[k].text);
+		hwords[k].text = NULL;
+	}
+	nhwords = 0;
+	hilite_gen++;
+	screen_trashed = 1;
+}
+
+/*
+ * Are there any --highlight words?
+ */
+	public int
+is_hiliting_words()
+{
+	return (nhwords > 0);
+}
+
+/*
+ * Return the n-th --highlight word, or NULL if there are fewer.
+ */
+	public char *
+get_hword(n)
+	int n;
+{
+	if (n < 0 || n >= nhwords)
+		return (NULL);
+	return (hwords[n].text);
+}
 #endif
 
 #if HAVE_V8_REGCOMP
@@ -9,6 +9,19 @@
 
 
 #include "less.h"
+#if HAVE_STAT
+#include <sys/stat.h>
+#endif
+#if HAVE_MMAP && HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#if HAVE_FORK
+#include <signal.h>
+#include <sys/wait.h>
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#endif
 
 #define	WHITESP(c)	((c)==' ' || (c)=='\t')
 
@@ -44,6 +57,7 @@ enum {
 };
 
 static enum tag_result findctag();
+static void addctag();
 static enum tag_result findgtag();
 static char *nextgtag();
 static char *prevgtag();
@@ -260,6 +274,316 @@ curr_tag()
  * ctags
  */
 
+/*
+ * The contents of the "tags" file, kept from one lookup to the next.
+ * If the file says it is sorted (with a "!_TAG_FILE_SORTED 1" header),
+ * tags are found by binary search.  Otherwise the first lookup builds
+ * a hash table of the lines in the file, which later lookups reuse.
+ */
+static struct {
+	char *name;		/* Name of the tags file */
+	POSITION size;		/* Size of the file when it was read */
+	time_type mtime;	/* Modification time when it was read */
+	char *data;		/* Contents of the file */
+	int mapped;		/* Is data mmap'ed? */
+	int sorted;		/* Is the file sorted by tag? */
+	int hashsize;		/* Number of entries in hash */
+	int *hash;		/* Index of first line with each hash value */
+	int *next;		/* Index of next line with the same hash value */
+	POSITION *lines;	/* Position of each line in the file */
+} ctf;
+
+/*
+ * Forget the contents of the tags file.
+ */
+	static void
+ctf_close()
+{
+	if (ctf.data != NULL)
+	{
+#if HAVE_MMAP && HAVE_SYS_MMAN_H
+		if (ctf.mapped)
+			munmap(ctf.data, (size_t) ctf.size);
+		else
+#endif
+			free(ctf.data);
+		ctf.data = NULL;
+	}
+	if (ctf.name != NULL)
+	{
+		free(ctf.name);
+		ctf.name = NULL;
+	}
+	if (ctf.hash != NULL)
+	{
+		free(ctf.hash);
+		free(ctf.next);
+		free(ctf.lines);
+		ctf.hash = NULL;
+	}
+}
+
+/*
+ * Make sure the contents of the named tags file are in memory.
+ * Return 0 if they are, -1 if the file can't be read,
+ * or 1 if it is too big to keep in memory.
+ */
+	static int
+ctf_open(name)
+	char *name;
+{
+	int f;
+	char *p;
+	POSITION size = 0;
+	time_type mtime = 0;
+	int n;
+	POSITION left;
+
+	f = open(name, OPEN_READ);
+	if (f < 0)
+		return (-1);
+#if HAVE_STAT
+	{
+		struct stat statbuf;
+		if (fstat(f, &statbuf) == 0)
+		{
+			size = statbuf.st_size;
+			mtime = statbuf.st_mtime;
+		}
+	}
+#else
+	size = filesize(f);
+#endif
+	if (ctf.data != NULL && strcmp(name, ctf.name) == 0 &&
+	    size == ctf.size && mtime == ctf.mtime)
+	{
+		/* We already have it. */
+		close(f);
+		return (0);
+	}
+	ctf_close();
+	if (size <= 0 || size != (POSITION) (size_t) size)
+	{
+		close(f);
+		return (1);
+	}
+	ctf.mapped = 0;
+#if HAVE_MMAP && HAVE_SYS_MMAN_H
+	ctf.data = (char *) mmap(NULL, (size_t) size, PROT_READ, MAP_PRIVATE, f, 0);
+	if (ctf.data == (char *) MAP_FAILED)
+		ctf.data = NULL;
+	else
+		ctf.mapped = 1;
+#endif
+	if (ctf.data == NULL)
+	{
+		/*
+		 * Can't map it; read it instead.
+		 */
+		ctf.data = (char *) malloc((size_t) size);
+		if (ctf.data == NULL)
+		{
+			close(f);
+			return (1);
+		}
+		for (p = ctf.data;  p < ctf.data + size;  p += n)
+		{
+			left = ctf.data + size - p;
+			n = read(f, p, (unsigned int) ((left < 65536) ? left : 65536));
+			if (n <= 0)
+			{
+				free(ctf.data);
+				ctf.data = NULL;
+				close(f);
+				return (-1);
+			}
+		}
+	}
+	close(f);
+	ctf.name = save(name);
+	ctf.size = size;
+	ctf.mtime = mtime;
+
+	/*
+	 * Look through the header lines to see if the file is sorted.
+	 */
+	ctf.sorted = 0;
+	for (p = ctf.data;  p < ctf.data + size && *p == '!';  p++)
+	{
+		if (strncmp(p, "!_TAG_FILE_SORTED\t1", 19) == 0)
+			ctf.sorted = 1;
+		while (p < ctf.data + size && *p != '\n')
+			p++;
+	}
+	return (0);
+}
+
+/*
+ * Copy the line starting at the given position into a buffer,
+ * truncating it if necessary.
+ * Return the position of the next line.
+ */
+	static POSITION
+ctf_getline(pos, buf, len)
+	POSITION pos;
+	char *buf;
+	int len;
+{
+	char *p = ctf.data + pos;
+	char *ep = ctf.data + ctf.size;
+
+	while (p < ep && *p != '\n')
+	{
+		if (len > 1)
+		{
+			*buf++ = *p;
+			len--;
+		}
+		p++;
+	}
+	*buf = '\0';
+	if (p < ep)
+		p++;
+	return (p - ctf.data);
+}
+
+/*
+ * Compare a tag with the tag at the start of the line at
+ * the given position, in the order used to sort tags files.
+ */
+	static int
+ctf_tagcmp(tag, taglen, pos)
+	char *tag;
+	int taglen;
+	POSITION pos;
+{
+	char *p = ctf.data + pos;
+	char *ep = ctf.data + ctf.size;
+	int i;
+	int c1, c2;
+
+	for (i = 0;  ;  i++)
+	{
+		/* The end of a tag sorts before any character. */
+		c1 = (i < taglen) ? (unsigned char) tag[i] : -1;
+		c2 = (p+i < ep && !WHITESP(p[i]) && p[i] != '\n') ?
+			(unsigned char) p[i] : -1;
+		if (c1 != c2)
+			return (c1 - c2);
+		if (c1 < 0)
+			return (0);
+	}
+}
+
+/*
+ * Find the first line in a sorted tags file which
+ * contains the tag, by binary search.
+ */
+	static POSITION
+ctf_bsearch(tag, taglen)
+	char *tag;
+	int taglen;
+{
+	POSITION lo = 0;
+	POSITION hi = ctf.size;
+	POSITION mid;
+
+	/*
+	 * Every line which starts before lo has a smaller tag;
+	 * every line which starts at or after hi does not.
+	 */
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo) / 2;
+		while (mid > lo && ctf.data[mid-1] != '\n')
+			mid--;
+		if (ctf_tagcmp(tag, taglen, mid) > 0)
+		{
+			while (mid < hi && ctf.data[mid] != '\n')
+				mid++;
+			lo = mid + 1;
+		} else
+			hi = mid;
+	}
+	return (lo);
+}
+
+/*
+ * Hash a tag name.
+ */
+	static unsigned int
+ctf_hash(p, len)
+	char *p;
+	int len;
+{
+	unsigned int h = 0;
+
+	while (--len >= 0)
+		h = h * 31 + (unsigned char) *p++;
+	return (h);
+}
+
+/*
+ * Build a hash table of the lines in an unsorted tags file.
+ * Return 0 if successful.
+ */
+	static int
+ctf_index()
+{
+	POSITION pos;
+	int nlines;
+	int i;
+	int len;
+	unsigned int h;
+
+	nlines = 0;
+	for (pos = 0;  pos < ctf.size;  pos++)
+		if (ctf.data[pos] == '\n')
+			nlines++;
+	nlines++;
+	for (ctf.hashsize = 64;  ctf.hashsize < nlines;  ctf.hashsize *= 2)
+		continue;
+	ctf.hash = (int *) malloc(ctf.hashsize * sizeof(int));
+	ctf.next = (int *) malloc(nlines * sizeof(int));
+	ctf.lines = (POSITION *) malloc(nlines * sizeof(POSITION));
+	if (ctf.hash == NULL || ctf.next == NULL || ctf.lines == NULL)
+	{
+		if (ctf.hash != NULL) free(ctf.hash);
+		if (ctf.next != NULL) free(ctf.next);
+		if (ctf.lines != NULL) free(ctf.lines);
+		ctf.hash = NULL;
+		return (-1);
+	}
+	for (i = 0;  i < ctf.hashsize;  i++)
+		ctf.hash[i] = -1;
+	nlines = 0;
+	for (pos = 0;  pos < ctf.size;  )
+	{
+		ctf.lines[nlines++] = pos;
+		while (pos < ctf.size && ctf.data[pos] != '\n')
+			pos++;
+		pos++;
+	}
+	/*
+	 * Insert the lines in reverse order, so each
+	 * hash chain is in the same order as the file.
+	 */
+	for (i = nlines;  --i >= 0;  )
+	{
+		pos = ctf.lines[i];
+		for (len = 0;  pos+len < ctf.size; len++)
+		{
+			int c = ctf.data[pos+len];
+			if (WHITESP(c) || c == '\n')
+				break;
+		}
+		h = ctf_hash(ctf.data + pos, len) & (ctf.hashsize - 1);
+		ctf.next[i] = ctf.hash[h];
+		ctf.hash[h] = i;
+	}
+	return (0);
+}
+
 /*
  * Find tags in the "tags" file.
  * Sets curtag to the first tag entry.
@@ -271,101 +595,69 @@ findctag(tag)
 	char *p;
 	register FILE *f;
 	register int taglen;
-	LINENUM taglinenum;
-	char *tagfile;
-	char *tagpattern;
-	int tagendline;
-	int search_char;
-	int err;
+	int r;
+	int i;
+	POSITION pos;
 	char tline[TAGLINE_SIZE];
-	struct tag *tp;
 
 	p = shell_unquote(tags);
-	f = fopen(p, "r");
-	free(p);
-	if (f == NULL)
+	r = ctf_open(p);
+	if (r < 0)
+	{
+		free(p);
 		return TAG_NOFILE;
+	}
 
 	cleantags();
 	total = 0;
 	taglen = (int) strlen(tag);
 
-	/*
-	 * Search the tags file for the desired tag.
-	 */
-	while (fgets(tline, sizeof(tline), f) != NULL)
+	if (r > 0)
 	{
-		if (tline[0] == '!')
-			/* Skip header of extended format. */
-			continue;
-		if (strncmp(tag, tline, taglen) != 0 || !WHITESP(tline[taglen]))
-			continue;
-
-		/*
-		 * Found it.
-		 * The line contains the tag, the filename and the
-		 * location in the file, separated by white space.
-		 * The location is either a decimal line number, 
-		 * or a search pattern surrounded by a pair of delimiters.
-		 * Parse the line and extract these parts.
-		 */
-		tagpattern = NULL;
-
-		/*
-		 * Skip over the whitespace after the tag name.
-		 */
-		p = skipsp(tline+taglen);
-		if (*p == '\0')
-			/* File name is missing! */
-			continue;
-
-		/*
-		 * Save the file name.
-		 * Skip over the whitespace after the file name.
-		 */
-		tagfile = p;
-		while (!WHITESP(*p) && *p != '\0')
-			p++;
-		*p++ = '\0';
-		p = skipsp(p);
-		if (*p == '\0')
-			/* Pattern is missing! */
-			continue;
-
 		/*
-		 * First see if it is a line number. 
+		 * The file is too big to keep in memory;
+		 * just read through it.
 		 */
-		tagendline = 0;
-		taglinenum = getnum(&p, 0, &err);
-		if (err)
+		f = fopen(p, "r");
+		free(p);
+		if (f == NULL)
+			return TAG_NOFILE;
+		while (fgets(tline, sizeof(tline), f) != NULL)
+			addctag(tag, taglen, tline);
+		fclose(f);
+	} else
+	{
+		free(p);
+		if (ctf.sorted)
 		{
 			/*
-			 * No, it must be a pattern.
-			 * Delete the initial "^" (if present) and 
-			 * the final "$" from the pattern.
-			 * Delete any backslash in the pattern.
+			 * Find the first matching line,
+			 * then read matching lines till there are no more.
 			 */
-			taglinenum = 0;
-			search_char = *p++;
-			if (*p == '^')
-				p++;
-			tagpattern = p;
-			while (*p != search_char && *p != '\0')
+			for (pos = ctf_bsearch(tag, taglen);  pos < ctf.size;  )
 			{
-				if (*p == '\\')
-					p++;
-				p++;
+				if (ctf_tagcmp(tag, taglen, pos) != 0)
+					break;
+				pos = ctf_getline(pos, tline, sizeof(tline));
+				addctag(tag, taglen, tline);
+			}
+		} else if (ctf.hash != NULL || ctf_index() == 0)
+		{
+			i = ctf.hash[ctf_hash(tag, taglen) & (ctf.hashsize - 1)];
+			for ( ;  i >= 0;  i = ctf.next[i])
+			{
+				(void) ctf_getline(ctf.lines[i], tline, sizeof(tline));
+				addctag(tag, taglen, tline);
+			}
+		} else
+		{
+			for (pos = 0;  pos < ctf.size;  )
+			{
+				pos = ctf_getline(pos, tline, sizeof(tline));
+				addctag(tag, taglen, tline);
 			}
-			tagendline = (p[-1] == '$');
-			if (tagendline)
-				p--;
-			*p = '\0';
 		}
-		tp = maketagent(tag, tagfile, taglinenum, tagpattern, tagendline);
-		TAG_INS(tp);
-		total++;
 	}
-	fclose(f);
 	if (total == 0)
 		return TAG_NOTAG;
 	curtag = taglist.tl_first;
@@ -373,6 +665,96 @@ findctag(tag)
 	return TAG_FOUND;
 }
 
+/*
+ * If a line from the tags file contains the given tag,
+ * add it to the tag list.
+ */
+	static void
+addctag(tag, taglen, tline)
+	char *tag;
+	int taglen;
+	char *tline;
+{
+	char *p;
+	LINENUM taglinenum;
+	char *tagfile;
+	char *tagpattern;
+	int tagendline;
+	int search_char;
+	int err;
+	struct tag *tp;
+
+	if (tline[0] == '!')
+		/* Skip header of extended format. */
+		return;
+	if (strncmp(tag, tline, taglen) != 0 || !WHITESP(tline[taglen]))
+		return;
+
+	/*
+	 * Found it.
+	 * The line contains the tag, the filename and the
+	 * location in the file, separated by white space.
+	 * The location is either a decimal line number, 
+	 * or a search pattern surrounded by a pair of delimiters.
+	 * Parse the line and extract these parts.
+	 */
+	tagpattern = NULL;
+
+	/*
+	 * Skip over the whitespace after the tag name.
+	 */
+	p = skipsp(tline+taglen);
+	if (*p == '\0')
+		/* File name is missing! */
+		return;
+
+	/*
+	 * Save the file name.
+	 * Skip over the whitespace after the file name.
+	 */
+	tagfile = p;
+	while (!WHITESP(*p) && *p != '\0')
+		p++;
+	*p++ = '\0';
+	p = skipsp(p);
+	if (*p == '\0')
+		/* Pattern is missing! */
+		return;
+
+	/*
+	 * First see if it is a line number. 
+	 */
+	tagendline = 0;
+	taglinenum = getnum(&p, 0, &err);
+	if (err)
+	{
+		/*
+		 * No, it must be a pattern.
+		 * Delete the initial "^" (if present) and 
+		 * the final "$" from the pattern.
+		 * Delete any backslash in the pattern.
+		 */
+		taglinenum = 0;
+		search_char = *p++;
+		if (*p == '^')
+			p++;
+		tagpattern = p;
+		while (*p != search_char && *p != '\0')
+		{
+			if (*p == '\\')
+				p++;
+			p++;
+		}
+		tagendline = (p[-1] == '$');
+		if (tagendline)
+			p--;
+		*p = '\0';
+	}
+	tp = maketagent(tag, tagfile, taglinenum, tagpattern, tagendline);
+	TAG_INS(tp);
+	total++;
+}
+
 /*
  * Edit current tagged file.
  */
@@ -462,10 +844,287 @@ ctagsearch()
  * gtags
  */
 
+/*
+ * A tag server is a command, named by LESSGLOBALSERVER, which runs for
+ * the whole session.  Each request is a line containing the global(1)
+ * flags and the tag; the reply is the "-x" output followed by an empty line.
+ */
+#if HAVE_FORK
+static FILE *gsrv_in = NULL;	/* Requests to the tag server */
+static FILE *gsrv_out = NULL;	/* Replies from the tag server */
+static int gsrv_failed = 0;	/* Couldn't start the tag server */
+static int gsrv_pid = -1;	/* Process id of the tag server */
+#endif
+
+/*
+ * Recent results of global(1), most recent first.
+ */
+#define	NGCACHE		16
+static struct gcache {
+	int gc_type;		/* Tags type */
+	char *gc_tag;		/* Tag name */
+	char *gc_data;		/* Output of global(1) */
+} gcache[NGCACHE];
+
+/*
+ * Read the output of global(1) into an allocated buffer.
+ * Lines longer than the parser can handle are truncated.
+ * If serv is set, stop at an empty line.
+ * Return NULL if interrupted.
+ */
+	static char *
+readgtags(fp, serv)
+	FILE *fp;
+	int serv;
+{
+	char buf[256];
+	char *data;
+	char *ndata;
+	size_t size = 1024;
+	size_t used = 0;
+	size_t len;
+
+	data = (char *) ecalloc(size, sizeof(char));
+	while (fgets(buf, sizeof(buf), fp))
+	{
+		if (sigs)
+		{
+			free(data);
+			return (NULL);
+		}
+		len = strlen(buf);
+		if (len > 0 && buf[len-1] == '\n')
+			buf[--len] = '\0';
+		else
+		{
+			int c;
+			do {
+				c = fgetc(fp);
+			} while (c != '\n' && c != EOF);
+		}
+		if (serv && len == 0)
+			break;
+		if (used + len + 2 > size)
+		{
+			size *= 2;
+			ndata = (char *) ecalloc(size, sizeof(char));
+			memcpy(ndata, data, used);
+			free(data);
+			data = ndata;
+		}
+		memcpy(data + used, buf, len);
+		used += len;
+		data[used++] = '\n';
+	}
+	data[used] = '\0';
+	return (data);
+}
+
+#if HAVE_FORK
+/*
+ * Stop the tag server.
+ */
+	static void
+gsrv_close()
+{
+	int status;
+
+	if (gsrv_in != NULL)
+		fclose(gsrv_in);
+	if (gsrv_out != NULL)
+		fclose(gsrv_out);
+	gsrv_in = gsrv_out = NULL;
+	if (gsrv_pid > 0)
+	{
+		/*
+		 * Kill it if it is still running, and reap it.
+		 */
+		if (waitpid(gsrv_pid, &status, WNOHANG) == 0)
+		{
+			kill(gsrv_pid, SIGTERM);
+			while (waitpid(gsrv_pid, &status, 0) < 0)
+			{
+#if HAVE_ERRNO
+				if (errno != EINTR)
+					break;
+#else
+				break;
+#endif
+			}
+		}
+		gsrv_pid = -1;
+	}
+}
+
+/*
+ * Start the tag server, if it isn't running already.
+ * Return 0 if it is running.
+ */
+	static int
+gsrv_open()
+{
+	char *cmd;
+	char *shell;
+	int req[2];
+	int rep[2];
+	int pid;
+
+	if (gsrv_in != NULL)
+		return (0);
+	if (gsrv_failed)
+		return (-1);
+	cmd = lgetenv("LESSGLOBALSERVER");
+	if (cmd == NULL || *cmd == '\0')
+		return (-1);
+	gsrv_failed = 1;
+	if (pipe(req) < 0)
+		return (-1);
+	if (pipe(rep) < 0)
+	{
+		close(req[0]);
+		close(req[1]);
+		return (-1);
+	}
+	shell = lgetenv("SHELL");
+	if (shell == NULL || *shell == '\0')
+		shell = "sh";
+	pid = fork();
+	if (pid == 0)
+	{
+		/*
+		 * In the child: run the server with
+		 * its stdin and stdout on the pipes.
+		 */
+		dup2(req[0], 0);
+		dup2(rep[1], 1);
+		close(req[0]); close(req[1]);
+		close(rep[0]); close(rep[1]);
+		execlp(shell, shell, "-c", cmd, (char *) NULL);
+		_exit(127);
+	}
+	close(req[0]);
+	close(rep[1]);
+	if (pid < 0)
+	{
+		close(req[1]);
+		close(rep[0]);
+		return (-1);
+	}
+	gsrv_pid = pid;
+#if HAVE_FCNTL_H && defined(FD_CLOEXEC)
+	/* Other commands run by less shouldn't inherit the pipes. */
+	fcntl(req[1], F_SETFD, FD_CLOEXEC);
+	fcntl(rep[0], F_SETFD, FD_CLOEXEC);
+#endif
+	gsrv_in = fdopen(req[1], "w");
+	gsrv_out = fdopen(rep[0], "r");
+	if (gsrv_in == NULL || gsrv_out == NULL)
+	{
+		if (gsrv_in == NULL) close(req[1]);
+		if (gsrv_out == NULL) close(rep[0]);
+		gsrv_close();
+		return (-1);
+	}
+	gsrv_failed = 0;
+	return (0);
+}
+
+/*
+ * Ask the tag server for a tag.
+ * Return NULL if it can't be asked.
+ */
+	static char *
+gsrv_lookup(flag, tag)
+	char *flag;
+	char *tag;
+{
+	char *data;
+	int err;
+
+	if (gsrv_open() < 0)
+		return (NULL);
+#ifdef SIGPIPE
+	LSIGNAL(SIGPIPE, SIG_IGN);
+#endif
+	fprintf(gsrv_in, "-x%s %s\n", flag, tag);
+	err = (fflush(gsrv_in) != 0);
+#ifdef SIGPIPE
+	LSIGNAL(SIGPIPE, SIG_DFL);
+#endif
+	if (err)
+	{
+		/* The server has gone away. */
+		gsrv_close();
+		return (NULL);
+	}
+	data = readgtags(gsrv_out, 1);
+	if (data == NULL || feof(gsrv_out) || ferror(gsrv_out))
+	{
+		/*
+		 * Interrupted, or the server has gone away; 
+		 * either way we can't rely on it any more.
+		 */
+		gsrv_close();
+	}
+	return (data);
+}
+#endif
+
+/*
+ * Find the cached output of global(1) for a tag.
+ */
+	static char *
+gcache_get(type, tag)
+	int type;
+	char *tag;
+{
+	struct gcache gc;
+	int i;
+
+	for (i = 0;  i < NGCACHE && gcache[i].gc_tag != NULL;  i++)
+	{
+		if (gcache[i].gc_type == type && strcmp(gcache[i].gc_tag, tag) == 0)
+		{
+			/* Move it to the front. */
+			gc = gcache[i];
+			for ( ;  i > 0;  i--)
+				gcache[i] = gcache[i-1];
+			gcache[0] = gc;
+			return (gc.gc_data);
+		}
+	}
+	return (NULL);
+}
+
+/*
+ * Remember the output of global(1) for a tag,
+ * forgetting the least recently used one if necessary.
+ */
+	static void
+gcache_put(type, tag, data)
+	int type;
+	char *tag;
+	char *data;
+{
+	int i;
+
+	if (gcache[NGCACHE-1].gc_tag != NULL)
+	{
+		free(gcache[NGCACHE-1].gc_tag);
+		free(gcache[NGCACHE-1].gc_data);
+	}
+	for (i = NGCACHE-1;  i > 0;  i--)
+		gcache[i] = gcache[i-1];
+	gcache[0].gc_type = type;
+	gcache[0].gc_tag = save(tag);
+	gcache[0].gc_data = data;
+}
+
 /*
  * Find tags in the GLOBAL's tag file.
  * The findgtag() will try and load information about the requested tag.
- * It does this by calling "global -x tag" and storing the parsed output
+ * It does this by asking the tag server, or else by calling 
+ * "global -x tag", and storing the parsed output
  * for future use by gtagsearch().
  * Sets curtag to the first tag entry.
  */
@@ -474,8 +1133,9 @@ findgtag(tag, type)
 	char *tag;		/* tag to load */
 	int type;		/* tags type */
 {
-	char buf[256];
-	FILE *fp;
+	char *data;
+	char *p;
+	char *eol;
 	struct tag *tp;
 
 	if (type != T_CTAGS_X && tag == NULL)
@@ -486,25 +1146,29 @@ findgtag(tag, type)
 
 	/*
 	 * If type == T_CTAGS_X then read ctags's -x format from stdin
-	 * else execute global(1) and read from it.
+	 * else get it from the cache, the tag server or global(1).
 	 */
 	if (type == T_CTAGS_X)
 	{
-		fp = stdin;
+		data = readgtags(stdin, 0);
+		if (data == NULL)
+			return TAG_INTR;
 		/* Set tag default because we cannot read stdin again. */
 		tags = ztags;
+	} else if ((p = gcache_get(type, tag)) != NULL)
+	{
+		data = save(p);
 	} else
 	{
 #if !HAVE_POPEN
 		return TAG_NOFILE;
 #else
+		FILE *fp;
 		char *command;
 		char *flag;
 		char *qtag;
-		char *cmd = lgetenv("LESSGLOBALTAGS");
+		char *cmd;
 
-		if (cmd == NULL || *cmd == '\0')
-			return TAG_NOFILE;
 		/* Get suitable flag value for global(1). */
 		switch (type)
 		{
@@ -524,69 +1188,67 @@ findgtag(tag, type)
 			return TAG_NOTYPE;
 		}
 
-		/* Get our data from global(1). */
-		qtag = shell_quote(tag);
-		if (qtag == NULL)
-			qtag = tag;
-		command = (char *) ecalloc(strlen(cmd) + strlen(flag) +
-				strlen(qtag) + 5, sizeof(char));
-		sprintf(command, "%s -x%s %s", cmd, flag, qtag);
-		if (qtag != tag)
-			free(qtag);
-		fp = popen(command, "r");
-		free(command);
+		data = NULL;
+#if HAVE_FORK
+		data = gsrv_lookup(flag, tag);
+		if (data == NULL && sigs)
+			return TAG_INTR;
 #endif
-	}
-	if (fp != NULL)
-	{
-		while (fgets(buf, sizeof(buf), fp))
+		if (data == NULL)
 		{
-			char *name, *file, *line;
-			int len;
-
-			if (sigs)
+			cmd = lgetenv("LESSGLOBALTAGS");
+			if (cmd == NULL || *cmd == '\0')
+				return TAG_NOFILE;
+			/* Get our data from global(1). */
+			qtag = shell_quote(tag);
+			if (qtag == NULL)
+				qtag = tag;
+			command = (char *) ecalloc(strlen(cmd) + strlen(flag) +
+					strlen(qtag) + 5, sizeof(char));
+			sprintf(command, "%s -x%s %s", cmd, flag, qtag);
+			if (qtag != tag)
+				free(qtag);
+			fp = popen(command, "r");
+			free(command);
+			if (fp == NULL)
+				return TAG_NOTAG;
+			data = readgtags(fp, 0);
+			if (data == NULL)
 			{
-#if HAVE_POPEN
-				if (fp != stdin)
-					pclose(fp);
-#endif
+				pclose(fp);
 				return TAG_INTR;
 			}
-			len = (int) strlen(buf);
-			if (len > 0 && buf[len-1] == '\n')
-				buf[len-1] = '\0';
-			else
+			if (pclose(fp))
 			{
-				int c;
-				do {
-					c = fgetc(fp);
-				} while (c != '\n' && c != EOF);
+				free(data);
+				return TAG_NOFILE;
 			}
+		}
+		gcache_put(type, tag, save(data));
+#endif
+	}
 
- 			if (getentry(buf, &name, &file, &line))
-			{
-				/*
-				 * Couldn't parse this line for some reason.
-				 * We'll just pretend it never happened.
-				 */
-				break;
-			}
+	for (p = data;  *p != '\0';  p = eol + 1)
+	{
+		char *name, *file, *line;
 
-			/* Make new entry and add to list. */
-			tp = maketagent(name, file, (LINENUM) atoi(line), NULL, 0);
-			TAG_INS(tp);
-			total++;
-		}
-		if (fp != stdin)
+		eol = strchr(p, '\n');
+		*eol = '\0';
+ 		if (getentry(p, &name, &file, &line))
 		{
-			if (pclose(fp))
-			{
-				curtag = NULL;
-				total = curseq = 0;
-				return TAG_NOFILE;
-			}
+			/*
+			 * Couldn't parse this line for some reason.
+			 * We'll just pretend it never happened.
+			 */
+			break;
 		}
+
+		/* Make new entry and add to list. */
+		tp = maketagent(name, file, (LINENUM) atoi(line), NULL, 0);
+		TAG_INS(tp);
+		total++;
 	}
+	free(data);
 
 	/* Check to see if we found anything. */
 	tp = taglist.tl_first;
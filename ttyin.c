@@ -120,6 +120,11 @@ getchr()
 		if (c == '\003')
 			return (READ_INTR);
 #else
+		/*
+		 * This is the end of whatever we were drawing;
+		 * send it to the screen before we wait for a key.
+		 */
+		flush();
 		result = iread(tty, &c, sizeof(char));
 		if (result == READ_INTR)
 			return (READ_INTR);